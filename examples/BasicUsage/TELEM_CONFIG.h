@@ -19,7 +19,8 @@ const TelemetryNodeConfig TELEM_CONFIG = {
         "EVENT_DEVICE_OFFLINE", // --------------------------- MQTT last will JSON string
         true, // ------------------------------ MQTT last will retain
         1, // --------------------------------- MQTT last will QOS
-      }
+      },
+      false, // ---------------------------- keep the TLS session in RTC memory across resets (ESP8266, stores the master secret in plaintext)
   },
   /* DEVICE */
   {
@@ -51,6 +52,7 @@ const TelemetryNodeConfig TELEM_CONFIG = {
     900000, // ---------------------------- Heartbeat timeout  (15 min as ms)
     30000, // ----------------------------- Time to wait between MQTT connection retry attempts
     60000, // ----------------------------- Time to wait before restarting the device after too many failed connect attempts
+    0, // --------------------------------- Max time in ms a run loop phase may take before the stall watchdog restarts the device (0 disables)
   },
   /* TOPIC CONFIGURATION */
   {
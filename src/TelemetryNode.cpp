@@ -1,5 +1,19 @@
 #include "TelemetryNode.h"
 
+/* marks a valid stall record in RTC memory */
+#define TELEMETRY_STALL_MAGIC 0x54454C4D
+
+/* marks a valid TLS session record in RTC memory */
+#define TELEMETRY_TLS_SESSION_MAGIC 0x544C5353
+
+static_assert((TELEMETRY_EVENT_QUEUE_SIZE & (TELEMETRY_EVENT_QUEUE_SIZE - 1)) == 0,
+  "TELEMETRY_EVENT_QUEUE_SIZE must be a power of two");
+
+#if defined(ESP32)
+/* survives software and watchdog resets, not power loss */
+RTC_NOINIT_ATTR static TelemetryStallRecord rtcStallRecord;
+#endif
+
 /** Returns a user readable representation */
 const char* telemEventToString(TelemetryEventType eventType) {
   switch (eventType) {
@@ -23,6 +37,41 @@ const char* telemEventToString(TelemetryEventType eventType) {
   }
 }
 
+/** Returns a user readable representation */
+const char* telemPhaseToString(TelemetryPhase phase) {
+  switch (phase) {
+    case PHASE_POLL:
+      return "PHASE_POLL";
+
+    case PHASE_ACTION:
+      return "PHASE_ACTION";
+
+    case PHASE_KEEP_ALIVE:
+      return "PHASE_KEEP_ALIVE";
+
+    case PHASE_HEARTBEAT:
+      return "PHASE_HEARTBEAT";
+
+    case PHASE_CONNECT_WIFI:
+      return "PHASE_CONNECT_WIFI";
+
+    case PHASE_CONNECT_MQTT:
+      return "PHASE_CONNECT_MQTT";
+
+    case PHASE_USER_TASK:
+      return "PHASE_USER_TASK";
+
+    case PHASE_EVENTS:
+      return "PHASE_EVENTS";
+
+    case PHASE_PUBLISH:
+      return "PHASE_PUBLISH";
+
+    default:
+      return "PHASE_NONE";
+  }
+}
+
 char* getTimeFromMillis() {
   unsigned long milliseconds = millis();
   static char timeString[9];  // Buffer for "HH:MM:SS\0"
@@ -42,6 +91,217 @@ char* getTimeFromMillis() {
 void TelemetryNode::begin() {
   /* start the debug logger + Serial */
   log->begin(telemConfig.device.serial_baud_rate);
+
+  /* restore the stall watchdog state from before the reset */
+  _loadStallRecord();
+  _startStallWatchdog();
+
+  /* restore the TLS session from before the reset so the first connect can resume it */
+  if (secureClient != nullptr) {
+    _loadTlsSession();
+  }
+}
+
+void TelemetryNode::_loadTlsSession() {
+#if defined(ESP8266)
+  TelemetryTlsSessionRecord record;
+  ESP.rtcUserMemoryRead(TELEMETRY_RTC_TLS_SESSION_OFFSET, (uint32_t*)&record, sizeof(record));
+
+  if (record.magic == TELEMETRY_TLS_SESSION_MAGIC) {
+    if (telemConfig.connection.tls_session_persist_rtc) {
+      tlsSession = record.session;
+    } else {
+      /* persistence is off, wipe the master secret a previous build left in RTC memory */
+      TelemetryTlsSessionRecord emptyRecord = {};
+      ESP.rtcUserMemoryWrite(TELEMETRY_RTC_TLS_SESSION_OFFSET, (uint32_t*)&emptyRecord, sizeof(emptyRecord));
+    }
+  }
+
+  /* BearSSL resumes from and updates the session on every connect */
+  secureClient->setSession(&tlsSession);
+#endif
+}
+
+/**
+ * Keeps the TLS session in RTC memory so the first connect after a reset can
+ * resume it. RTC memory isn't encrypted: the master secret is stored in
+ * plaintext, so this only runs when tls_session_persist_rtc is enabled.
+ */
+void TelemetryNode::_saveTlsSession() {
+#if defined(ESP8266)
+  if (!telemConfig.connection.tls_session_persist_rtc) {
+    return;
+  }
+
+  TelemetryTlsSessionRecord record;
+  record.magic = TELEMETRY_TLS_SESSION_MAGIC;
+  record.session = tlsSession;
+  ESP.rtcUserMemoryWrite(TELEMETRY_RTC_TLS_SESSION_OFFSET, (uint32_t*)&record, sizeof(record));
+#endif
+}
+
+void TelemetryNode::_loadStallRecord() {
+  /* stall watchdog disabled, the RTC memory isn't ours */
+  if (telemConfig.timeout.loop_stall_deadline <= 0) {
+    return;
+  }
+
+#if defined(ESP32)
+  stallRecord = rtcStallRecord;
+
+  esp_reset_reason_t reason = esp_reset_reason();
+  bool isResetByWatchdog = reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT;
+#elif defined(ESP8266)
+  ESP.rtcUserMemoryRead(TELEMETRY_RTC_STALL_OFFSET, (uint32_t*)&stallRecord, sizeof(stallRecord));
+
+  uint32_t reason = ESP.getResetInfoPtr()->reason;
+  bool isResetByWatchdog = reason == REASON_WDT_RST || reason == REASON_SOFT_WDT_RST;
+#endif
+
+  /* RTC memory holds garbage after power on, start with a clean record */
+  if (stallRecord.magic != TELEMETRY_STALL_MAGIC
+      || stallRecord.phase > PHASE_PUBLISH
+      || stallRecord.stall_phase > PHASE_PUBLISH) {
+    stallRecord = { TELEMETRY_STALL_MAGIC, PHASE_NONE, 0, PHASE_NONE, 0 };
+  }
+
+  /* hardware watchdog fired before the stall watchdog did, blame the running phase */
+  if (isResetByWatchdog && stallRecord.stall_phase == PHASE_NONE) {
+    stallRecord.stall_phase = stallRecord.phase;
+    stallRecord.stall_duration = 0;  // unknown, the phase never reached a check
+  }
+
+  /* snapshot the stall behind this reset, it's reported with the reset reason */
+  stats.reset_stall_phase = (TelemetryPhase)stallRecord.stall_phase;
+  stats.reset_stall_duration = stallRecord.stall_duration;
+
+  stallRecord.phase = PHASE_NONE;
+  stallRecord.phase_start = millis();
+  stallRecord.stall_phase = PHASE_NONE;
+  stallRecord.stall_duration = 0;
+  _saveStallRecord();
+}
+
+void TelemetryNode::_saveStallRecord() {
+#if defined(ESP32)
+  rtcStallRecord = stallRecord;
+#elif defined(ESP8266)
+  ESP.rtcUserMemoryWrite(TELEMETRY_RTC_STALL_OFFSET, (uint32_t*)&stallRecord, sizeof(stallRecord));
+#endif
+}
+
+/**
+ * Starts checking the running phase against the stall deadline. The checks
+ * run outside of loop() so a phase that never returns is still caught.
+ */
+void TelemetryNode::_startStallWatchdog() {
+  /* stall watchdog disabled */
+  if (telemConfig.timeout.loop_stall_deadline <= 0) {
+    return;
+  }
+
+#if defined(ESP32)
+  /* runs above loopTask's priority so a busy loop can't starve it */
+  xTaskCreate(_stallWatchdogTask, "telemStallWdt", 2048, this, 2, &stallTaskHandle);
+#elif defined(ESP8266)
+  stallTicker.attach_ms(TELEMETRY_STALL_CHECK_INTERVAL, _onStallTicker, this);
+#endif
+}
+
+#if defined(ESP32)
+/**
+ * Owns its own task watchdog subscription instead of relying on loopTask's,
+ * which the core keeps feeding. The subscription is only fed while the
+ * running phase is within the deadline.
+ */
+void TelemetryNode::_stallWatchdogTask(void *telemNode) {
+  TelemetryNode *node = (TelemetryNode*)telemNode;
+  bool isSubscribed = esp_task_wdt_add(NULL) == ESP_OK;
+  unsigned long tsStalled = 0;
+
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(TELEMETRY_STALL_CHECK_INTERVAL));
+
+    if (tsStalled == 0 && !node->_checkStallDeadline()) {
+      if (isSubscribed) {
+        esp_task_wdt_reset();
+      }
+      continue;
+    }
+
+    if (tsStalled == 0) {
+      tsStalled = millis();
+    }
+
+    /* task watchdog not running or set to not panic, restart the device ourselves */
+    if (!isSubscribed || millis() - tsStalled >= (CONFIG_ESP_TASK_WDT_TIMEOUT_S + 1) * 1000UL) {
+      esp_restart();
+    }
+  }
+}
+#elif defined(ESP8266)
+/**
+ * Ticker callbacks run from the system context between loop() yields, where
+ * ESP.restart() can't be used. A phase that blocks without yielding is caught
+ * by the core's software watchdog instead, blamed by _loadStallRecord().
+ */
+void TelemetryNode::_onStallTicker(TelemetryNode *telemNode) {
+  if (telemNode->_checkStallDeadline()) {
+    system_restart();
+  }
+}
+#endif
+
+/**
+ * Marks the start of a run loop phase. A phase that overran the deadline
+ * but completed before the watchdog check is counted in the stats only.
+ */
+void TelemetryNode::_enterPhase(TelemetryPhase phase) {
+  long deadline = telemConfig.timeout.loop_stall_deadline;
+
+  /* stall watchdog disabled, nothing to track */
+  if (deadline <= 0) {
+    return;
+  }
+
+  unsigned long elapsed = millis() - watchedPhaseStart;
+
+  if (watchedPhase != PHASE_NONE && elapsed >= (unsigned long)deadline) {
+    stats.last_stall_phase = (TelemetryPhase)watchedPhase;
+    stats.last_stall_duration = elapsed;
+
+    log->print("[TelemetryNode]: stall watchdog, phase overran deadline -> ");
+    log->print(telemPhaseToString(stats.last_stall_phase));
+    log->print(" ms -> ");
+    log->println(elapsed);
+  }
+
+  stallRecord.phase = phase;
+  stallRecord.phase_start = millis();
+  _saveStallRecord();
+
+  /* start before phase, the watchdog never pairs a new phase with an old start */
+  watchedPhaseStart = stallRecord.phase_start;
+  watchedPhase = phase;
+}
+
+/**
+ * Checks the running phase against the stall deadline. Records the stall in
+ * RTC memory for the next boot and returns true once the phase has overrun.
+ */
+bool TelemetryNode::_checkStallDeadline() {
+  uint32_t phase = watchedPhase;
+  unsigned long elapsed = millis() - watchedPhaseStart;
+
+  if (phase == PHASE_NONE || elapsed < (unsigned long)telemConfig.timeout.loop_stall_deadline) {
+    return false;
+  }
+
+  stallRecord.stall_phase = phase;
+  stallRecord.stall_duration = elapsed;
+  _saveStallRecord();
+
+  return true;
 }
 
 void TelemetryNode::connect() {
@@ -61,6 +321,8 @@ void TelemetryNode::connect() {
 }
 
 void TelemetryNode::_connectToWiFi() {
+  _enterPhase(PHASE_CONNECT_WIFI);
+
   log->print("[TelemetryNode]: attempting WiFi connection to SSID: ");
   log->println(telemConfig.connection.wifi_ssid);
 
@@ -86,6 +348,8 @@ void TelemetryNode::_connectToWiFi() {
       log->print(".");
       tsDotLast = millis();
     }
+
+    yield();
   }
 
   log->println("\n[TelemetryNode]: WiFi connected!");
@@ -112,7 +376,14 @@ void TelemetryNode::_sendMqttWill() {
   mqttClient->endWill();  // lwt is ready!
 }
 
-void TelemetryNode::_connectToMqttHost(uint8_t attemptNumber) {
+/**
+ * Connects to the broker and publishes the online event, reset reason and
+ * heartbeat. Returns true when the broker accepted the connection, even if
+ * a missed PUBACK during those publishes dropped it again.
+ */
+bool TelemetryNode::_connectToMqttHost(uint8_t attemptNumber) {
+  _enterPhase(PHASE_CONNECT_MQTT);
+
   /* check if we've maxed out reconnect attempts */
   if (attemptNumber > telemConfig.connection.mqtt_connect_reconnect_tries) {
     log->println("[TelemetryNode]: max retries reached! RESTARTING!");
@@ -143,8 +414,40 @@ void TelemetryNode::_connectToMqttHost(uint8_t attemptNumber) {
   log->print("[TelemetryNode]: Connecting to MQTT broker with ID -> ");
   log->println(telemConfig.connection.mqtt_client_id);
 
-  /* attemp the connection and handle connection failure */
-  if (!mqttClient->connect(telemConfig.connection.mqtt_broker_ip_addr, telemConfig.connection.mqtt_broker_port)) {
+#if defined(ESP8266)
+  /* a session that comes back unchanged from the handshake was resumed */
+  BearSSL::Session previousTlsSession = tlsSession;
+#endif
+
+  /* attemp the connection and time the handshake */
+  unsigned long tsConnectStart = millis();
+  bool isConnected = mqttClient->connect(telemConfig.connection.mqtt_broker_ip_addr, telemConfig.connection.mqtt_broker_port);
+  stats.last_handshake_duration = millis() - tsConnectStart;
+
+  log->print("[TelemetryNode]: MQTT connect handshake ms -> ");
+  log->println(stats.last_handshake_duration);
+
+  if (isConnected) {
+    stats.mqtt_connects++;
+  } else {
+    stats.mqtt_connect_failures++;
+  }
+
+#if defined(ESP8266)
+  if (isConnected && secureClient != nullptr) {
+    BearSSL::Session emptyTlsSession;
+
+    if (memcmp(&previousTlsSession, &emptyTlsSession, sizeof(emptyTlsSession)) != 0
+        && memcmp(&previousTlsSession, &tlsSession, sizeof(tlsSession)) == 0) {
+      stats.tls_sessions_resumed++;
+    }
+
+    _saveTlsSession();
+  }
+#endif
+
+  /* handle connection failure */
+  if (!isConnected) {
     ledStatus->flashIndefinitely(50);
     log->print("[TelemetryNode]: MQTT broker connection FAILED! connection error -> ");
     log->println(mqttClient->connectError());
@@ -156,7 +459,7 @@ void TelemetryNode::_connectToMqttHost(uint8_t attemptNumber) {
       yield();
     }
 
-    _connectToMqttHost(attemptNumber++);  // try connecting again
+    isConnected = _connectToMqttHost(attemptNumber++);  // try connecting again
   }
 
   yield();
@@ -169,10 +472,13 @@ void TelemetryNode::_connectToMqttHost(uint8_t attemptNumber) {
   yield();
   _publishHeartbeat();
   yield();
+
+  return isConnected;
 }
 
 
 void TelemetryNode::_keepAlive() {
+  _enterPhase(PHASE_KEEP_ALIVE);
   yield();
   log->println("[TelemetryNode]: running keep alive logic");
 
@@ -187,12 +493,12 @@ void TelemetryNode::_keepAlive() {
   }
 
   log->println("[TelemetryNode]: MQTT client NOT CONNECTED! Attempting reconnect...");
-  _connectToMqttHost(0);  // attempt to connect to the MQTT broker
+  tsLastKeepAlive = millis();
 
-  if (mqttClient->connected()) {
+  /* a PUBACK missed while connecting drops the connection again and forces the next keep alive */
+  if (_connectToMqttHost(0)) {  // attempt to connect to the MQTT broker
     yield();
     log->println("[TelemetryNode]: MQTT client reconnection SUCCESS");
-    tsLastKeepAlive = millis();
 
     /* broadcast telemetry event - MQTT_RECONNECT */
     _publishDeviceEvent(EVENT_DEVICE_RECONNECT);
@@ -216,6 +522,8 @@ void TelemetryNode::_publishHeartbeat() {
     return;
   }
 
+  _enterPhase(PHASE_HEARTBEAT);
+
   /* device is config'd for heartbeats.. send heartbeat */
 
   /* publish a heartbeat event */
@@ -271,23 +579,153 @@ void TelemetryNode::publishEvent(String eventName) {
   yield();
 }
 
+/**
+ * Compare and swap for the interrupt event queue. The ESP8266 has no atomic
+ * instructions, interrupts are masked around it instead.
+ */
+static IRAM_ATTR bool queueCompareAndSwap(volatile uint32_t *value, uint32_t expected, uint32_t desired) {
+#if defined(ESP8266)
+  uint32_t savedPs = xt_rsil(15);
+  bool isSwapped = *value == expected;
+
+  if (isSwapped) {
+    *value = desired;
+  }
+  xt_wsr_ps(savedPs);
+  return isSwapped;
+#else
+  return __sync_bool_compare_and_swap(value, expected, desired);
+#endif
+}
+
+/**
+ * Queues an event for publishing from run(). Safe to call from an interrupt
+ * handler: no allocation, no blocking and the capture time is recorded now.
+ * Returns false and counts an overflow when the queue is full.
+ *
+ * Lock-free for any number of producers: loop(), several ISRs and both ESP32
+ * cores. A producer claims a position with a compare and swap on the head,
+ * then marks its slot complete, run() only reads slots marked complete.
+ */
+IRAM_ATTR bool TelemetryNode::queueEvent(uint16_t eventId, int32_t value) {
+  uint32_t position;
+
+  do {
+    /* tail before head, the difference never underflows */
+    uint32_t tail = eventQueueTail;
+    position = eventQueueHead;
+
+    /* queue is full, drop the event */
+    if (position - tail >= TELEMETRY_EVENT_QUEUE_SIZE) {
+      uint32_t overflows;
+      do {
+        overflows = eventQueueOverflows;
+      } while (!queueCompareAndSwap(&eventQueueOverflows, overflows, overflows + 1));
+      return false;
+    }
+
+    /* another producer claimed the position first, try the next one */
+  } while (!queueCompareAndSwap(&eventQueueHead, position, position + 1));
+
+  TelemetryQueuedEvent &event = eventQueue[position % TELEMETRY_EVENT_QUEUE_SIZE];
+  event.timestamp = millis();
+  event.id = eventId;
+  event.value = value;
+
+  /* make sure the record is written before run() can see it */
+  __sync_synchronize();
+  event.sequence = position + 1;
+
+  return true;
+}
+
+/**
+ * Drains up to TELEMETRY_EVENT_BATCH_SIZE queued events into a single JSON
+ * message on the device events topic
+ */
+void TelemetryNode::_publishQueuedEvents() {
+  uint32_t tail = eventQueueTail;
+
+  /* nothing queued, or the oldest event is still being written */
+  if (eventQueue[tail % TELEMETRY_EVENT_QUEUE_SIZE].sequence != tail + 1) {
+    return;
+  }
+
+  _enterPhase(PHASE_EVENTS);
+
+  JsonDocument json;
+  json["ts"] = millis();
+  json["overflows"] = (uint32_t)eventQueueOverflows;
+  JsonArray events = json["events"].to<JsonArray>();
+
+  uint8_t batchSize = 0;
+  while (batchSize < TELEMETRY_EVENT_BATCH_SIZE) {
+    TelemetryQueuedEvent &queuedEvent = eventQueue[tail % TELEMETRY_EVENT_QUEUE_SIZE];
+
+    /* stop at the first slot a producer hasn't completed, events stay in order */
+    if (queuedEvent.sequence != tail + 1) {
+      break;
+    }
+
+    /* read the record only after seeing the sequence that published it */
+    __sync_synchronize();
+
+    JsonObject event = events.add<JsonObject>();
+    event["id"] = queuedEvent.id;
+    event["value"] = queuedEvent.value;
+    event["ts"] = queuedEvent.timestamp;
+
+    tail++;
+    batchSize++;
+  }
+
+  /* release the slots before the blocking publish so interrupts can keep queueing */
+  __sync_synchronize();
+  eventQueueTail = tail;
+
+  yield();
+  // publish EVENTS
+  mqttClient->beginMessage(
+    telemConfig.topic.device_events,
+    measureJson(json),
+    false, // queued events are transient, don't replace the retained device event
+    0);
+
+  serializeJson(json, *mqttClient);
+  mqttClient->endMessage();
+  mqttClient->flush();
+
+  stats.events_published += batchSize;
+
+  yield();
+}
+
 void TelemetryNode::_publishDeviceResetReason() {
   yield();
 
-  // publish EVENT
-  mqttClient->beginMessage(
-    telemConfig.topic.device_reset_reason,
-    telemConfig.device.retain_reset_reason,
-    telemConfig.device.qos_reset_reason);
+  char payload[TELEMETRY_QOS_PAYLOAD_SIZE];
 
 #if defined(ESP32)
-  mqttClient->print(esp_reset_reason());
+  int length = snprintf(payload, sizeof(payload), "%d", (int)esp_reset_reason());
 #elif defined(ESP8266)
-  mqttClient->print(ESP.getResetReason());
+  int length = snprintf(payload, sizeof(payload), "%s", ESP.getResetReason().c_str());
 #endif
 
-  mqttClient->endMessage();
-  mqttClient->flush();
+  /* attach the phase that stalled before the reset and how long it ran */
+  if (stats.reset_stall_phase != PHASE_NONE && length > 0 && length < (int)sizeof(payload)) {
+    snprintf(
+      payload + length,
+      sizeof(payload) - length,
+      " stalled:%s:%lums",
+      telemPhaseToString(stats.reset_stall_phase),
+      stats.reset_stall_duration);
+  }
+
+  _publishMessage(
+    telemConfig.topic.device_reset_reason,
+    payload,
+    telemConfig.device.retain_reset_reason,
+    telemConfig.device.qos_reset_reason);
 
   yield();
 }
@@ -299,56 +737,185 @@ void TelemetryNode::publishWifiSignal() {
   char* timeAlive = getTimeFromMillis();
   int8_t rssi = WiFi.RSSI();
 
-  // publish EVENT
-  mqttClient->beginMessage(
+  char payload[8];
+  snprintf(payload, sizeof(payload), "%d", rssi);
+
+  _publishMessage(
     telemConfig.topic.wifi_signal,
+    payload,
     telemConfig.device.wifi_signal.is_broadcasting,
     telemConfig.device.wifi_signal.qos);
 
-  mqttClient->print(rssi);
-  mqttClient->endMessage();
-  mqttClient->flush();
-
   yield();
 }
 
 void TelemetryNode::publishMemoryAvailable() {
   yield();
 
-  // publish EVENT
-  mqttClient->beginMessage(
+  char payload[12];
+  snprintf(payload, sizeof(payload), "%lu", (unsigned long)ESP.getFreeHeap());
+
+  _publishMessage(
     telemConfig.topic.memory_available,
+    payload,
     telemConfig.device.heap_memory.is_retained,
     telemConfig.device.heap_memory.qos);
 
-  mqttClient->print(ESP.getFreeHeap());
-  mqttClient->endMessage();
-  mqttClient->flush();
-
   yield();
 }
 
 void TelemetryNode::publishTimeAlive() {
   yield();
 
-  // publish EVENT
-  mqttClient->beginMessage(
+  _publishMessage(
     telemConfig.topic.time_alive,
+    getTimeFromMillis(),
     telemConfig.device.time_alive.is_retained,
     telemConfig.device.time_alive.qos);
 
-  mqttClient->print(getTimeFromMillis());
-  mqttClient->endMessage();
-  mqttClient->flush();
+  yield();
+}
+
+/**
+ * Publishes a message. QoS 1+ messages wait for the broker's acknowledgement
+ * and are kept to resend after a reconnect when it never arrives.
+ */
+void TelemetryNode::_publishMessage(const char* topic, const char* payload, bool retain, uint8_t qos) {
+  if (qos == 0) {
+    // publish MESSAGE
+    mqttClient->beginMessage(topic, retain, qos);
+    mqttClient->print(payload);
+    mqttClient->endMessage();
+    mqttClient->flush();
+    return;
+  }
+
+  TelemetryQosMessage message;
+  message.topic = topic;
+  strncpy(message.payload, payload, sizeof(message.payload) - 1);
+  message.payload[sizeof(message.payload) - 1] = '\0';
+  message.retain = retain;
+  message.qos = qos;
+  message.attempts = 0;
+
+  /* keep the publish order, older messages are still waiting to be resent */
+  if (qosResendCount > 0 || !_sendQosMessage(message)) {
+    _bufferQosResend(message);
+  }
+}
+
+/**
+ * Sends a QoS 1+ message and waits for its acknowledgement. MqttClient
+ * waits for up to its connection timeout and keeps the connection open when
+ * the acknowledgement never arrives, so the connection is dropped here and
+ * the next run() reconnects.
+ */
+bool TelemetryNode::_sendQosMessage(TelemetryQosMessage &message) {
+  if (!mqttClient->connected()) {
+    return false;
+  }
+
+  message.attempts++;
+
+  yield();
+  unsigned long tsSent = millis();
+
+  // publish MESSAGE
+  mqttClient->beginMessage(message.topic, strlen(message.payload), message.retain, message.qos);
+  mqttClient->print(message.payload);
+
+  if (!mqttClient->endMessage()) {
+    stats.qos_ack_timeouts++;
+    log->print("[TelemetryNode]: QoS acknowledgement TIMED OUT for topic -> ");
+    log->println(message.topic);
+
+    /* drop the stuck connection and force a keep alive on the next run to reconnect */
+    mqttClient->stop();
+    tsLastKeepAlive = millis() - telemConfig.timeout.keep_alive;
+    return false;
+  }
+
+  /* acknowledged, record latency */
+  stats.last_ack_latency = millis() - tsSent;
+  if (stats.last_ack_latency > stats.max_ack_latency) {
+    stats.max_ack_latency = stats.last_ack_latency;
+  }
+  stats.qos_acked++;
 
   yield();
+  return true;
+}
+
+void TelemetryNode::_bufferQosResend(const TelemetryQosMessage &message) {
+  /* buffer is full, drop the oldest unacknowledged message */
+  if (qosResendCount == TELEMETRY_QOS_RESEND_BUFFER_SIZE) {
+    log->print("[TelemetryNode]: QoS resend buffer full, dropping message for topic -> ");
+    log->println(qosResend[qosResendTail].topic);
+
+    qosResendTail = (qosResendTail + 1) % TELEMETRY_QOS_RESEND_BUFFER_SIZE;
+    qosResendCount--;
+    stats.qos_dropped++;
+  }
+
+  qosResend[(qosResendTail + qosResendCount) % TELEMETRY_QOS_RESEND_BUFFER_SIZE] = message;
+  qosResendCount++;
+  stats.qos_pending = qosResendCount;
+}
+
+/**
+ * Resends the oldest unacknowledged QoS message, at most one per call.
+ * MqttClient gives it a new packet id, so it goes out as a new publish
+ * without the DUP flag and the broker may deliver it twice.
+ */
+void TelemetryNode::_resendQosMessage() {
+  /* nothing waiting, or no connection to send it on */
+  if (qosResendCount == 0 || !mqttClient->connected()) {
+    return;
+  }
+
+  _enterPhase(PHASE_PUBLISH);
+
+  TelemetryQosMessage &message = qosResend[qosResendTail];
+  stats.qos_resends++;
+
+  bool isAcknowledged = _sendQosMessage(message);
+
+  /* give up on messages the broker never acknowledged */
+  if (!isAcknowledged && message.attempts >= TELEMETRY_QOS_MAX_ATTEMPTS) {
+    log->print("[TelemetryNode]: QoS message never acknowledged, dropping message for topic -> ");
+    log->println(message.topic);
+    stats.qos_dropped++;
+  }
+
+  if (isAcknowledged || message.attempts >= TELEMETRY_QOS_MAX_ATTEMPTS) {
+    qosResendTail = (qosResendTail + 1) % TELEMETRY_QOS_RESEND_BUFFER_SIZE;
+    qosResendCount--;
+    stats.qos_pending = qosResendCount;
+  }
 }
 
 void TelemetryNode::run() {
+  /* leaving user code, track internal work until run returns */
+  _enterPhase(PHASE_POLL);
+  _runTasks();
+  _enterPhase(PHASE_USER_TASK);
+}
+
+void TelemetryNode::_runTasks() {
   yield();
   mqttClient->poll();  // poll the MQTT client to keep the connection alive
   yield();
 
+  /* publish events queued by interrupt handlers */
+  _publishQueuedEvents();
+
+  /* resend a QoS message the broker didn't acknowledge before the reconnect */
+  _resendQosMessage();
+
+  if (_actionFlag != ACTION_FLAG_RUN) {
+    _enterPhase(PHASE_ACTION);
+  }
+
   /* CHECK ACTION FLAG */
   /* if heartbeat */
   if (_actionFlag == ACTION_FLAG_PUBLISH_HEARTBEAT) {
@@ -411,17 +978,43 @@ JsonDocument TelemetryNode::processIncomingMessage(int _messageSize) {
   log->print("  [Topic]: ");
   log->println(mqttClient->messageTopic());
 
-  /* convert the message into a string */
-  char payloadString[_messageSize];
+  JsonDocument json;
+
+  /* nothing to parse, ignore empty or invalid message sizes */
+  if (_messageSize <= 0) {
+    log->println("[TelemetryNode]: empty action message, ignoring");
+    return json;
+  }
+
+  /* actions larger than the payload buffer can't be valid, drain and ignore */
+  if (_messageSize > TELEMETRY_MAX_ACTION_PAYLOAD_SIZE) {
+    log->print("[TelemetryNode]: action message too large, ignoring -> ");
+    log->println(_messageSize);
 
-  /*use the Stream interface to print the contents */
-  for (int i = 0; i < _messageSize; i++) {
-    payloadString[i] = (char)mqttClient->read();
+    _readIncomingMessage(nullptr, _messageSize);
+    return json;
+  }
+
+  /* read the payload into a fixed size buffer */
+  uint8_t payload[TELEMETRY_MAX_ACTION_PAYLOAD_SIZE];
+  int bytesRead = _readIncomingMessage(payload, _messageSize);
+
+  /* payload ended before the announced size, don't act on a partial action */
+  if (bytesRead < _messageSize) {
+    log->print("[TelemetryNode]: action message truncated, ignoring -> ");
+    log->println(bytesRead);
+    return json;
+  }
+
+  /* parse the payload into JSON */
+  DeserializationError error = deserializeJson(json, payload, bytesRead);
+
+  if (error) {
+    log->print("[TelemetryNode]: action message parse FAILED -> ");
+    log->println(error.c_str());
+    return json;
   }
 
-  /* parse the string into JSON */
-  JsonDocument json;
-  deserializeJson(json, payloadString);
   int actionRequest = json["action"];
   long heartRate = json["heartRate"];
 
@@ -452,6 +1045,45 @@ JsonDocument TelemetryNode::processIncomingMessage(int _messageSize) {
   return json;
 }
 
+/**
+ * Reads up to size bytes of the incoming message into buffer, or discards
+ * them when buffer is null. A read may return fewer bytes than asked for and
+ * available() counts the message bytes still to come, not the bytes that
+ * arrived, so stop when the peer disconnects or sends nothing for
+ * TELEMETRY_ACTION_READ_TIMEOUT ms. Returns the number of bytes read.
+ */
+int TelemetryNode::_readIncomingMessage(uint8_t *buffer, int size) {
+  uint8_t discard[32];
+  int bytesRead = 0;
+  unsigned long tsLastRead = millis();
+
+  while (bytesRead < size && mqttClient->available() > 0) {
+    int chunkLimit = size - bytesRead;
+    uint8_t *chunk = buffer + bytesRead;
+
+    if (buffer == nullptr) {
+      chunk = discard;
+      chunkLimit = chunkLimit < (int)sizeof(discard) ? chunkLimit : (int)sizeof(discard);
+    }
+
+    int chunkSize = mqttClient->read(chunk, chunkLimit);
+
+    if (chunkSize > 0) {
+      bytesRead += chunkSize;
+      tsLastRead = millis();
+      continue;
+    }
+
+    /* peer dropped or stalled mid message */
+    if (!mqttClient->connected() || millis() - tsLastRead >= TELEMETRY_ACTION_READ_TIMEOUT) {
+      break;
+    }
+    yield();
+  }
+
+  return bytesRead;
+}
+
 void TelemetryNode::setDebugging(bool _isDebugging) {
   log->setLogging(_isDebugging);
 }
@@ -459,3 +1091,8 @@ void TelemetryNode::setDebugging(bool _isDebugging) {
 MqttClient* TelemetryNode::getMqttClient() {
   return mqttClient;
 }
+
+const TelemetryNodeStats& TelemetryNode::getStats() {
+  stats.event_queue_overflows = eventQueueOverflows;
+  return stats;
+}
@@ -16,6 +16,64 @@
 #error "Unsupported platform"
 #endif
 
+#include <WiFiClientSecure.h>
+
+#if defined(ESP32)
+#include <esp_task_wdt.h>
+#elif defined(ESP8266)
+#include <Ticker.h>
+#endif
+
+/* max size in bytes of an incoming action message, larger messages are ignored */
+#ifndef TELEMETRY_MAX_ACTION_PAYLOAD_SIZE
+#define TELEMETRY_MAX_ACTION_PAYLOAD_SIZE 256
+#endif
+
+/* max time in ms to wait for more bytes of an incoming action message before giving up on it */
+#ifndef TELEMETRY_ACTION_READ_TIMEOUT
+#define TELEMETRY_ACTION_READ_TIMEOUT 100
+#endif
+
+/* RTC user memory block (4 byte blocks) used to retain the stall record on ESP8266 */
+#ifndef TELEMETRY_RTC_STALL_OFFSET
+#define TELEMETRY_RTC_STALL_OFFSET 32
+#endif
+
+/* interval in ms at which the stall watchdog checks the running phase against the deadline */
+#ifndef TELEMETRY_STALL_CHECK_INTERVAL
+#define TELEMETRY_STALL_CHECK_INTERVAL 1000
+#endif
+
+/* RTC user memory block (4 byte blocks) used to retain the TLS session on ESP8266, see ConnectionConfig::tls_session_persist_rtc */
+#ifndef TELEMETRY_RTC_TLS_SESSION_OFFSET
+#define TELEMETRY_RTC_TLS_SESSION_OFFSET 40
+#endif
+
+/* number of events the interrupt event queue holds, must be a power of two */
+#ifndef TELEMETRY_EVENT_QUEUE_SIZE
+#define TELEMETRY_EVENT_QUEUE_SIZE 32
+#endif
+
+/* max number of queued events published in a single MQTT message */
+#ifndef TELEMETRY_EVENT_BATCH_SIZE
+#define TELEMETRY_EVENT_BATCH_SIZE 8
+#endif
+
+/* max number of unacknowledged QoS 1+ messages kept to resend after a reconnect */
+#ifndef TELEMETRY_QOS_RESEND_BUFFER_SIZE
+#define TELEMETRY_QOS_RESEND_BUFFER_SIZE 4
+#endif
+
+/* max payload size in bytes of a QoS 1+ message kept to resend */
+#ifndef TELEMETRY_QOS_PAYLOAD_SIZE
+#define TELEMETRY_QOS_PAYLOAD_SIZE 96
+#endif
+
+/* send attempts before an unacknowledged QoS 1+ message is dropped */
+#ifndef TELEMETRY_QOS_MAX_ATTEMPTS
+#define TELEMETRY_QOS_MAX_ATTEMPTS 5
+#endif
+
 /* Enum for device events */
 enum TelemetryEventType {
     EVENT_DEVICE_ONLINE,
@@ -35,8 +93,78 @@ enum DeviceActionFlag {
     ACTION_FLAG_REBOOT,
 };
 
+/* Enum for run loop phases tracked by the stall watchdog, values are kept in RTC memory: append only */
+enum TelemetryPhase {
+    PHASE_NONE,
+    PHASE_POLL,
+    PHASE_ACTION,
+    PHASE_KEEP_ALIVE,
+    PHASE_HEARTBEAT,
+    PHASE_CONNECT_WIFI,
+    PHASE_CONNECT_MQTT,
+    PHASE_USER_TASK,
+    PHASE_EVENTS,
+    PHASE_PUBLISH,
+};
+
 /* convenience method for user-friendly enum strings */
 const char* telemEventToString(TelemetryEventType eventType);
+const char* telemPhaseToString(TelemetryPhase phase);
+
+/* stall watchdog state, retained in RTC memory across resets */
+struct TelemetryStallRecord {
+    uint32_t magic;
+    uint32_t phase;           // phase currently running
+    uint32_t phase_start;     // millis() when the current phase was entered
+    uint32_t stall_phase;     // phase the stall watchdog restarted the device for
+    uint32_t stall_duration;  // time in ms the stalled phase had been running
+};
+
+#if defined(ESP8266)
+/* TLS session parameters, retained in RTC memory to resume sessions across resets. Holds the master secret in plaintext */
+struct TelemetryTlsSessionRecord {
+    uint32_t         magic;
+    BearSSL::Session session;
+};
+#endif
+
+/* QoS 1+ message kept to resend when the broker didn't acknowledge it */
+struct TelemetryQosMessage {
+    const char* topic;  // points into the topic config
+    char        payload[TELEMETRY_QOS_PAYLOAD_SIZE];
+    bool        retain;
+    uint8_t     qos;
+    uint8_t     attempts;
+};
+
+/* event record pushed from interrupt handlers, see TelemetryNode::queueEvent() */
+struct TelemetryQueuedEvent {
+    uint32_t timestamp;  // millis() when the event was captured
+    uint16_t id;         // user defined event id
+    int32_t  value;      // user defined event value
+    volatile uint32_t sequence;  // queue position + 1 once the record is complete
+};
+
+/* runtime instrumentation, see TelemetryNode::getStats() */
+struct TelemetryNodeStats {
+    TelemetryPhase reset_stall_phase;        // phase that stalled before the last reset, set once by begin()
+    unsigned long  reset_stall_duration;
+    TelemetryPhase last_stall_phase;         // last phase that overran the deadline since begin()
+    unsigned long  last_stall_duration;
+    unsigned long  events_published;
+    unsigned long  event_queue_overflows;
+    unsigned long  mqtt_connects;
+    unsigned long  mqtt_connect_failures;
+    unsigned long  last_handshake_duration;  // ms for the TCP, TLS and MQTT CONNECT handshake
+    unsigned long  tls_sessions_resumed;
+    uint8_t        qos_pending;              // unacknowledged messages waiting to be resent
+    unsigned long  qos_acked;
+    unsigned long  qos_ack_timeouts;
+    unsigned long  qos_resends;
+    unsigned long  qos_dropped;
+    unsigned long  last_ack_latency;
+    unsigned long  max_ack_latency;
+};
 
 struct LastWillConfig {
     bool          is_sending;
@@ -73,6 +201,7 @@ struct ConnectionConfig {
     bool           mqtt_use_clean_session;
     uint16_t       mqtt_connect_reconnect_tries;
     LastWillConfig last_will;
+    bool           tls_session_persist_rtc;  // ESP8266: keep the TLS session, master secret included, in RTC memory
 };
 
 struct TopicConfig {
@@ -90,6 +219,7 @@ struct TimeoutConfig {
     long     telemetry_heartbeat;
     long     mqtt_reconnect_try;
     uint16_t mqtt_failed_connect_restart_delay;
+    long     loop_stall_deadline;
 };
 
 struct TelemetryNodeConfig {
@@ -111,15 +241,44 @@ class TelemetryNode {
         RunnableLed *ledStatus;
 
         /* connection variables */
-        WiFiClient wiFiClient;
+        WiFiClientSecure *secureClient;
         MqttClient *mqttClient;
 
+#if defined(ESP8266)
+        /* TLS session cache, reused on every reconnect */
+        BearSSL::Session tlsSession;
+#endif
+
         /* action flag */
-        DeviceActionFlag _actionFlag;
+        DeviceActionFlag _actionFlag = ACTION_FLAG_RUN;
+
+        /* stall watchdog, the running phase is mirrored for the watchdog task/ticker */
+        TelemetryStallRecord stallRecord;
+        TelemetryNodeStats stats = {};
+        volatile uint32_t watchedPhase = PHASE_NONE;
+        volatile uint32_t watchedPhaseStart = 0;
+
+#if defined(ESP32)
+        TaskHandle_t stallTaskHandle = nullptr;
+#elif defined(ESP8266)
+        Ticker stallTicker;
+#endif
+
+        /* interrupt event queue, written by queueEvent() and drained by run(), head and tail are free running positions */
+        TelemetryQueuedEvent eventQueue[TELEMETRY_EVENT_QUEUE_SIZE] = {};
+        volatile uint32_t eventQueueHead = 0;
+        volatile uint32_t eventQueueTail = 0;
+        volatile uint32_t eventQueueOverflows = 0;
+
+        /* unacknowledged QoS messages, oldest message at qosResendTail */
+        TelemetryQosMessage qosResend[TELEMETRY_QOS_RESEND_BUFFER_SIZE];
+        uint8_t qosResendTail = 0;
+        uint8_t qosResendCount = 0;
 
         /* methods */
+        void _runTasks();
         void _connectToWiFi();
-        void _connectToMqttHost(uint8_t attemptNumber);
+        bool _connectToMqttHost(uint8_t attemptNumber);
         void _sendMqttWill();
         void _keepAlive();
         void _publishHeartbeat();
@@ -127,27 +286,62 @@ class TelemetryNode {
         void _logLn(char _message);
         void _publishDeviceEvent(TelemetryEventType eventType);
         void _publishDeviceResetReason();
+        void _loadStallRecord();
+        void _saveStallRecord();
+        void _enterPhase(TelemetryPhase phase);
+        void _startStallWatchdog();
+        bool _checkStallDeadline();
+#if defined(ESP32)
+        static void _stallWatchdogTask(void *telemNode);
+#elif defined(ESP8266)
+        static void _onStallTicker(TelemetryNode *telemNode);
+#endif
+        void _publishQueuedEvents();
+        int _readIncomingMessage(uint8_t *buffer, int size);
+        void _loadTlsSession();
+        void _publishMessage(const char* topic, const char* payload, bool retain, uint8_t qos);
+        bool _sendQosMessage(TelemetryQosMessage &message);
+        void _bufferQosResend(const TelemetryQosMessage &message);
+        void _resendQosMessage();
+        void _saveTlsSession();
 
         /* timestamps */
-        unsigned long tsLastKeepAlive;
-        unsigned long tsLastHeartbeat;
-        unsigned long tsLastMqttConnAttempt;
+        unsigned long tsLastKeepAlive = 0;
+        unsigned long tsLastHeartbeat = 0;
+        unsigned long tsLastMqttConnAttempt = 0;
 
     public:
         TelemetryNode(
-            WiFiClient _wiFiClient, 
+            WiFiClient &, 
+            MqttClient &_mqttClient,
+            RunnableLed &_ledStatus,
+            TelemetryNodeConfig _telemConfig
+        ): secureClient(nullptr), mqttClient(&_mqttClient), ledStatus(&_ledStatus), telemConfig(_telemConfig){
+            /* init the debug logger */
+            log = new DebugLogger(telemConfig.device.is_logging);
+        };
+        TelemetryNode(
+            WiFiClient &, 
+            MqttClient &_mqttClient,
+            TelemetryNodeConfig _telemConfig
+        ): secureClient(nullptr), mqttClient(&_mqttClient), ledStatus(nullptr), telemConfig(_telemConfig){
+            /* init the debug logger */
+            log = new DebugLogger(telemConfig.device.is_logging);
+        };
+        TelemetryNode(
+            WiFiClientSecure &_secureClient, 
             MqttClient &_mqttClient,
             RunnableLed &_ledStatus,
             TelemetryNodeConfig _telemConfig
-        ): wiFiClient(_wiFiClient), mqttClient(&_mqttClient), ledStatus(&_ledStatus), telemConfig(_telemConfig){
+        ): secureClient(&_secureClient), mqttClient(&_mqttClient), ledStatus(&_ledStatus), telemConfig(_telemConfig){
             /* init the debug logger */
             log = new DebugLogger(telemConfig.device.is_logging);
         };
         TelemetryNode(
-            WiFiClient _wiFiClient, 
+            WiFiClientSecure &_secureClient, 
             MqttClient &_mqttClient,
             TelemetryNodeConfig _telemConfig
-        ): wiFiClient(_wiFiClient), mqttClient(&_mqttClient), ledStatus(nullptr), telemConfig(_telemConfig){
+        ): secureClient(&_secureClient), mqttClient(&_mqttClient), ledStatus(nullptr), telemConfig(_telemConfig){
             /* init the debug logger */
             log = new DebugLogger(telemConfig.device.is_logging);
         };
@@ -161,6 +355,8 @@ class TelemetryNode {
         void publishTimeAlive();
         MqttClient* getMqttClient();
         void publishEvent(String eventName);
+        bool queueEvent(uint16_t eventId, int32_t value = 0);
+        const TelemetryNodeStats& getStats();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+/**
+ * Throughput of the incoming actions path through the shim MqttClient over
+ * a corpus of realistic action payloads: bench_actions [iterations]
+ * Reports messages/s and heap allocations per message. ArduinoJson allocates
+ * with malloc() and operator new ends up there too, so malloc, calloc and
+ * realloc are counted by wrapping glibc's.
+ */
+#include "host_node.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+static size_t allocationCount = 0;
+
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void *memory, size_t size);
+
+  void* malloc(size_t size) {
+    allocationCount++;
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size) {
+    allocationCount++;
+    return __libc_calloc(count, size);
+  }
+
+  void* realloc(void *memory, size_t size) {
+    allocationCount++;
+    return __libc_realloc(memory, size);
+  }
+}
+
+static WiFiClient wiFiClient;
+static MqttClient mqttClient(wiFiClient);
+static TelemetryNode telemNode(wiFiClient, mqttClient, hostNodeConfig());
+
+struct BenchCase {
+  const char *name;
+  std::string payload;
+  size_t      maxChunk;
+};
+
+int main(int argc, char **argv) {
+  long iterations = argc > 1 ? atol(argv[1]) : 200000;
+
+  telemNode.begin();
+
+  std::vector<BenchCase> corpus = {
+    { "heartbeat-request", "{ \"action\": 777 }", 0 },
+    { "set-heartrate", "{ \"action\": 444, \"heartRate\": 60000 }", 0 },
+    { "enable-heartbeat", "{\"action\":555}", 0 },
+    { "fleet-command", "{ \"action\": 777, \"fleet\": \"north-field\", \"issued\": 1718000000, \"by\": \"ops\" }", 0 },
+    { "short-reads", "{ \"action\": 444, \"heartRate\": 60000 }", 8 },
+    { "malformed", "{ \"action\": 444, \"heartRate\": ", 0 },
+  };
+
+  printf("%-18s %14s %12s\n", "payload", "messages/s", "allocs/msg");
+
+  for (const BenchCase &benchCase : corpus) {
+    const uint8_t *payload = (const uint8_t*)benchCase.payload.data();
+    size_t size = benchCase.payload.size();
+
+    size_t allocations = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long i = 0; i < iterations; i++) {
+      mqttClient.hostInjectMessage("host-node/actions", payload, size, benchCase.maxChunk);
+
+      /* only count the node's own allocations, not the shim's */
+      size_t allocationsBefore = allocationCount;
+      {
+        JsonDocument json = telemNode.processIncomingMessage(size);
+      }
+      allocations += allocationCount - allocationsBefore;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double allocationsPerMessage = (double)allocations / iterations;
+
+    printf("%-18s %14.0f %12.2f\n", benchCase.name, iterations / elapsed.count(), allocationsPerMessage);
+  }
+
+  return 0;
+}
@@ -0,0 +1,35 @@
+/**
+ * libFuzzer target for the incoming actions path. Input layout:
+ *   bytes 0-1  announced message size, little endian int16 (may be negative or exceed the payload)
+ *   byte  2    bits 0-6 max bytes returned per read, 0 for no limit (short reads)
+ *              bit 7 keeps the peer connected when the payload runs out (stall)
+ *   bytes 3-   payload delivered through the shim MqttClient, the peer stalls or
+ *              drops once it runs out before the announced size
+ */
+#include "host_node.h"
+
+static WiFiClient wiFiClient;
+static MqttClient mqttClient(wiFiClient);
+static TelemetryNode telemNode(wiFiClient, mqttClient, hostNodeConfig());
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size < 3) {
+    return 0;
+  }
+
+  int16_t messageSize = (int16_t)(data[0] | (data[1] << 8));
+  size_t maxChunk = data[2] & 0x7F;
+  size_t announcedSize = messageSize > 0 ? messageSize : 0;
+
+  mqttClient.hostSetConnected(data[2] & 0x80 ? 1 : 0);
+  mqttClient.hostInjectMessage("host-node/actions", data + 3, size - 3, maxChunk, announcedSize);
+  JsonDocument json = telemNode.processIncomingMessage(messageSize);
+
+  /* a parsed document always came from a complete, in-bounds payload */
+  if (!json.isNull()) {
+    HOST_CHECK(messageSize > 0);
+    HOST_CHECK(messageSize <= TELEMETRY_MAX_ACTION_PAYLOAD_SIZE);
+    HOST_CHECK((size_t)messageSize <= size - 3);
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * Standalone driver for fuzz targets when libFuzzer isn't available (GCC).
+ * Runs the built-in seeds, any corpus files given on the command line and a
+ * fixed-seed random mutation loop: fuzz_actions_standalone [--runs N] [files...]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static std::vector<uint8_t> seed(int16_t messageSize, uint8_t maxChunk, const char *payload) {
+  std::vector<uint8_t> input;
+  input.push_back(messageSize & 0xFF);
+  input.push_back((messageSize >> 8) & 0xFF);
+  input.push_back(maxChunk);
+  input.insert(input.end(), payload, payload + strlen(payload));
+  return input;
+}
+
+int main(int argc, char **argv) {
+  long runs = 100000;
+  std::vector<std::vector<uint8_t>> corpus;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+      runs = atol(argv[++i]);
+      continue;
+    }
+
+    std::ifstream file(argv[i], std::ios::binary);
+    corpus.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  corpus.push_back(seed(17, 0, "{ \"action\": 555 }"));
+  corpus.push_back(seed(17, 1, "{ \"action\": 555 }"));
+  corpus.push_back(seed(40, 3, "{ \"action\": 444, \"heartRate\": 60000 }"));
+  corpus.push_back(seed(200, 0, "{ \"action\": 999 }"));
+  corpus.push_back(seed(-1, 0, "{ \"action\": 777 }"));
+  corpus.push_back(seed(32767, 7, "[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]"));
+  corpus.push_back(seed(12, 0, "{\"a\":\"\\u00e9\"}"));
+  corpus.push_back(seed(40, 0x84, "{ \"action\": 555 }"));
+  corpus.push_back(seed(400, 0x85, "{ \"action\": 555, \"pad\": \"xxxxxxxx\" }"));
+
+  for (const std::vector<uint8_t> &input : corpus) {
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+
+  std::mt19937 random(1234);
+  for (long run = 0; run < runs; run++) {
+    std::vector<uint8_t> input = corpus[random() % corpus.size()];
+    int mutations = 1 + random() % 8;
+
+    for (int i = 0; i < mutations; i++) {
+      switch (random() % 4) {
+        case 0:
+          if (!input.empty()) {
+            input[random() % input.size()] = random() & 0xFF;
+          }
+          break;
+        case 1:
+          input.insert(input.begin() + random() % (input.size() + 1), random() & 0xFF);
+          break;
+        case 2:
+          if (!input.empty()) {
+            input.erase(input.begin() + random() % input.size());
+          }
+          break;
+        default:
+          input.resize(random() % (input.size() + 1));
+          break;
+      }
+    }
+
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+
+  printf("fuzz: %ld runs OK\n", runs + (long)corpus.size());
+  return 0;
+}
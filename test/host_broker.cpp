@@ -0,0 +1,236 @@
+#include "host_broker.h"
+
+#include <chrono>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+/* self-signed P-256 certificate for localhost, generated on every run */
+static void useSelfSignedCertificate(SSL_CTX *context) {
+  EVP_PKEY *key = EVP_EC_gen("P-256");
+  X509 *certificate = X509_new();
+
+  X509_set_version(certificate, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+  X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+  X509_gmtime_adj(X509_getm_notAfter(certificate), 3600);
+  X509_set_pubkey(certificate, key);
+
+  X509_NAME *name = X509_get_subject_name(certificate);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+  X509_set_issuer_name(certificate, name);
+  X509_sign(certificate, key, EVP_sha256());
+
+  SSL_CTX_use_certificate(context, certificate);
+  SSL_CTX_use_PrivateKey(context, key);
+
+  X509_free(certificate);
+  EVP_PKEY_free(key);
+}
+
+HostBroker::HostBroker(bool useTls) {
+  if (useTls) {
+    static const unsigned char sessionContext[] = "host-broker";
+
+    _context = SSL_CTX_new(TLS_server_method());
+    SSL_CTX_set_max_proto_version(_context, TLS1_2_VERSION);
+    SSL_CTX_set_options(_context, SSL_OP_NO_TICKET | SSL_OP_NO_EXTENDED_MASTER_SECRET);
+    SSL_CTX_set_session_cache_mode(_context, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_set_session_id_context(_context, sessionContext, sizeof(sessionContext) - 1);
+    useSelfSignedCertificate(_context);
+  }
+
+  _listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+  int reuse = 1;
+  setsockopt(_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  bind(_listenSocket, (struct sockaddr*)&address, sizeof(address));
+  listen(_listenSocket, 4);
+
+  socklen_t length = sizeof(address);
+  getsockname(_listenSocket, (struct sockaddr*)&address, &length);
+  _port = ntohs(address.sin_port);
+
+  _thread = std::thread(&HostBroker::_run, this);
+}
+
+HostBroker::~HostBroker() {
+  _isRunning = false;
+  _thread.join();
+  close(_listenSocket);
+
+  if (_context != nullptr) {
+    SSL_CTX_free(_context);
+  }
+}
+
+std::vector<HostBrokerPublish> HostBroker::publishes() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _publishes;
+}
+
+void HostBroker::_run() {
+  while (_isRunning) {
+    struct pollfd descriptor = { _listenSocket, POLLIN, 0 };
+    if (poll(&descriptor, 1, 20) <= 0) {
+      continue;
+    }
+
+    int socket = accept(_listenSocket, nullptr, nullptr);
+    if (socket >= 0) {
+      _isDropRequested = false;
+      _serve(socket);
+      close(socket);
+    }
+  }
+}
+
+/* one client connection, reads whole MQTT packets and answers them */
+void HostBroker::_serve(int socket) {
+  SSL *ssl = nullptr;
+
+  if (_context != nullptr) {
+    ssl = SSL_new(_context);
+    SSL_set_fd(ssl, socket);
+
+    if (SSL_accept(ssl) != 1) {
+      ERR_clear_error();
+      SSL_free(ssl);
+      return;
+    }
+
+    if (SSL_session_reused(ssl)) {
+      _resumedSessions++;
+    }
+  }
+  _connections++;
+
+  /* reads exactly size bytes, false when the client is gone or the connection is dropped */
+  auto readExact = [&](uint8_t *buffer, size_t size) {
+    size_t received = 0;
+
+    while (received < size) {
+      if (!_isRunning || _isDropRequested) {
+        return false;
+      }
+
+      if (ssl == nullptr || SSL_pending(ssl) == 0) {
+        struct pollfd descriptor = { socket, POLLIN, 0 };
+        if (poll(&descriptor, 1, 20) <= 0) {
+          continue;
+        }
+      }
+
+      int result = ssl != nullptr
+        ? SSL_read(ssl, buffer + received, size - received)
+        : (int)recv(socket, buffer + received, size - received, 0);
+
+      if (result <= 0) {
+        return false;
+      }
+      received += result;
+    }
+    return true;
+  };
+
+  auto writeAll = [&](const std::vector<uint8_t> &packet) {
+    if (ssl != nullptr) {
+      SSL_write(ssl, packet.data(), packet.size());
+    } else {
+      send(socket, packet.data(), packet.size(), MSG_NOSIGNAL);
+    }
+  };
+
+  for (;;) {
+    uint8_t header;
+    if (!readExact(&header, 1)) {
+      break;
+    }
+
+    size_t remaining = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+      uint8_t digit;
+      if (!readExact(&digit, 1)) {
+        goto done;
+      }
+      remaining |= (size_t)(digit & 0x7F) << shift;
+      if ((digit & 0x80) == 0) {
+        break;
+      }
+    }
+
+    std::vector<uint8_t> body(remaining);
+    if (remaining > 0 && !readExact(body.data(), remaining)) {
+      break;
+    }
+
+    switch (header & 0xF0) {
+      case 0x10: {  // CONNECT
+        std::this_thread::sleep_for(std::chrono::milliseconds(_connAckDelay.load()));
+        writeAll({ 0x20, 0x02, 0x00, 0x00 });
+        break;
+      }
+
+      case 0x30: {  // PUBLISH
+        HostBrokerPublish publish;
+        size_t topicLength = (body[0] << 8) | body[1];
+        size_t offset = 2 + topicLength;
+
+        publish.topic.assign((const char*)body.data() + 2, topicLength);
+        publish.qos = (header >> 1) & 0x03;
+        publish.dup = (header & 0x08) != 0;
+        publish.packetId = 0;
+
+        if (publish.qos > 0) {
+          publish.packetId = (body[offset] << 8) | body[offset + 1];
+          offset += 2;
+        }
+        publish.payload.assign((const char*)body.data() + offset, body.size() - offset);
+
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _publishes.push_back(publish);
+        }
+
+        if (publish.qos > 0 && _isAcking) {
+          writeAll({ 0x40, 0x02, (uint8_t)(publish.packetId >> 8), (uint8_t)publish.packetId });
+        }
+        break;
+      }
+
+      case 0x80: {  // SUBSCRIBE
+        writeAll({ 0x90, 0x03, body[0], body[1], 0x00 });
+        break;
+      }
+
+      case 0xC0: {  // PINGREQ
+        writeAll({ 0xD0, 0x00 });
+        break;
+      }
+
+      case 0xE0:  // DISCONNECT
+        goto done;
+
+      default:
+        break;
+    }
+  }
+
+done:
+  if (ssl != nullptr) {
+    /* a connection freed without close_notify drops its session from the cache */
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+  }
+}
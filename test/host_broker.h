@@ -0,0 +1,67 @@
+/**
+ * Loopback MQTT broker stand-in for the host tests. Serves one client at a
+ * time over TCP or TLS 1.2 (runtime generated self-signed certificate, no
+ * session tickets, server side session cache for session id resumption).
+ */
+#ifndef HOST_BROKER_H
+#define HOST_BROKER_H
+
+#include <ArduinoMqttClient.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef struct ssl_st SSL;
+typedef struct ssl_ctx_st SSL_CTX;
+
+/* a PUBLISH received by the broker */
+struct HostBrokerPublish {
+    std::string topic;
+    std::string payload;
+    uint8_t     qos;
+    bool        dup;
+    uint16_t    packetId;
+};
+
+class HostBroker {
+    public:
+        explicit HostBroker(bool useTls);
+        ~HostBroker();
+
+        uint16_t port() const { return _port; }
+
+        /* delay before CONNACK is sent, stretches the MQTT handshake */
+        void setConnAckDelay(unsigned long ms) { _connAckDelay = ms; }
+
+        /* when false QoS 1 publishes are received but never acknowledged */
+        void setAckPublishes(bool isAcking) { _isAcking = isAcking; }
+
+        /* closes the current client connection */
+        void dropClient() { _isDropRequested = true; }
+
+        int connections() const { return _connections; }
+        int resumedSessions() const { return _resumedSessions; }
+        std::vector<HostBrokerPublish> publishes();
+
+    private:
+        int _listenSocket = -1;
+        uint16_t _port = 0;
+        SSL_CTX *_context = nullptr;
+        std::thread _thread;
+        std::mutex _mutex;
+        std::vector<HostBrokerPublish> _publishes;
+
+        std::atomic<bool> _isRunning{true};
+        std::atomic<bool> _isDropRequested{false};
+        std::atomic<bool> _isAcking{true};
+        std::atomic<unsigned long> _connAckDelay{0};
+        std::atomic<int> _connections{0};
+        std::atomic<int> _resumedSessions{0};
+
+        void _run();
+        void _serve(int socket);
+};
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * Shared helpers for the host tests: a quiet node configuration and
+ * minimal assertions.
+ */
+#ifndef HOST_NODE_H
+#define HOST_NODE_H
+
+#include <TelemetryNode.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HOST_CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: CHECK FAILED: %s\n", __FILE__, __LINE__, #condition); \
+      exit(1); \
+    } \
+  } while (0)
+
+/* no logging, no heartbeats and timers that never fire unless a test moves the clock */
+inline TelemetryNodeConfig hostNodeConfig(const char *brokerHost = "127.0.0.1", int brokerPort = 1883) {
+  TelemetryNodeConfig config = {};
+
+  strcpy(config.connection.wifi_ssid, "host");
+  strcpy(config.connection.mqtt_broker_ip_addr, brokerHost);
+  config.connection.mqtt_broker_port = brokerPort;
+  config.connection.mqtt_client_id = "host-node";
+  config.connection.mqtt_use_clean_session = true;
+  config.connection.mqtt_connect_reconnect_tries = 1;
+
+  config.device.is_logging = false;
+  config.device.heartbeat_enabled = false;
+
+  config.timeout.keep_alive = 0x3FFFFFFF;
+  config.timeout.telemetry_heartbeat = 0x3FFFFFFF;
+  config.timeout.mqtt_reconnect_try = 10;
+
+  strcpy(config.topic.incoming_actions, "host-node/actions");
+  strcpy(config.topic.device_events, "host-node/device/events");
+  strcpy(config.topic.device_reset_reason, "host-node/device/reset");
+  strcpy(config.topic.time_alive, "host-node/device/alive-time");
+  strcpy(config.topic.wifi_signal, "host-node/device/wifi");
+  strcpy(config.topic.memory_available, "host-node/device/heap");
+
+  return config;
+}
+
+#endif
@@ -0,0 +1,244 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <Ticker.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+EspClass ESP;
+WiFiClass WiFi;
+
+static const std::chrono::steady_clock::time_point hostStart = std::chrono::steady_clock::now();
+static unsigned long hostMillisOffset = 0;
+static uint8_t hostRtcMemory[512];
+static rst_info hostResetInfo = { REASON_DEFAULT_RST };
+static int hostRestarts = 0;
+
+unsigned long millis() {
+  auto elapsed = std::chrono::steady_clock::now() - hostStart;
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() + hostMillisOffset;
+}
+
+unsigned long micros() {
+  auto elapsed = std::chrono::steady_clock::now() - hostStart;
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + hostMillisOffset * 1000;
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  Ticker::hostRunDue();
+}
+
+void yield() {
+  std::this_thread::yield();
+  Ticker::hostRunDue();
+}
+
+static std::recursive_mutex hostInterruptLock;
+
+uint32_t xt_rsil(uint32_t level) {
+  hostInterruptLock.lock();
+  return 0;
+}
+
+void xt_wsr_ps(uint32_t state) {
+  hostInterruptLock.unlock();
+}
+
+void hostAdvanceMillis(unsigned long ms) {
+  hostMillisOffset += ms;
+}
+
+void hostSetResetReason(uint32 reason) {
+  hostResetInfo.reason = reason;
+}
+
+int hostRestartCount() {
+  return hostRestarts;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+  while (size--) {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+void EspClass::restart() {
+  hostRestarts++;
+}
+
+extern "C" void system_restart(void) {
+  hostRestarts++;
+}
+
+String EspClass::getResetReason() {
+  switch (hostResetInfo.reason) {
+    case REASON_WDT_RST:
+      return String("Hardware Watchdog");
+    case REASON_EXCEPTION_RST:
+      return String("Exception");
+    case REASON_SOFT_WDT_RST:
+      return String("Software Watchdog");
+    case REASON_SOFT_RESTART:
+      return String("Software/System restart");
+    case REASON_DEEP_SLEEP_AWAKE:
+      return String("Deep-Sleep Wake");
+    case REASON_EXT_SYS_RST:
+      return String("External System");
+    default:
+      return String("Power On");
+  }
+}
+
+rst_info* EspClass::getResetInfoPtr() {
+  return &hostResetInfo;
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size) {
+  if (offset * 4 + size > sizeof(hostRtcMemory) || size == 0) {
+    return false;
+  }
+  memcpy(data, hostRtcMemory + offset * 4, size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size) {
+  if (offset * 4 + size > sizeof(hostRtcMemory) || size == 0) {
+    return false;
+  }
+  memcpy(hostRtcMemory + offset * 4, data, size);
+  return true;
+}
+
+WiFiClient::~WiFiClient() {
+  stop();
+}
+
+int WiFiClient::_connectSocket(const char *host, uint16_t port) {
+  struct addrinfo hints = {};
+  struct addrinfo *result = nullptr;
+  char service[8];
+
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(service, sizeof(service), "%u", port);
+
+  if (getaddrinfo(host, service, &hints, &result) != 0) {
+    return -1;
+  }
+
+  int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if (fd >= 0 && ::connect(fd, result->ai_addr, result->ai_addrlen) != 0) {
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(result);
+
+  if (fd >= 0) {
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+  }
+  return fd;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  char host[16];
+  uint32_t address = ip.value();
+  snprintf(host, sizeof(host), "%u.%u.%u.%u",
+    (unsigned)(address >> 24) & 0xFF, (unsigned)(address >> 16) & 0xFF,
+    (unsigned)(address >> 8) & 0xFF, (unsigned)address & 0xFF);
+  return connect(host, port);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  stop();
+  _socket = _connectSocket(host, port);
+  return _socket >= 0 ? 1 : 0;
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size) {
+  if (_socket < 0) {
+    return 0;
+  }
+
+  size_t written = 0;
+  while (written < size) {
+    ssize_t result = send(_socket, buffer + written, size - written, MSG_NOSIGNAL);
+    if (result <= 0) {
+      stop();
+      break;
+    }
+    written += result;
+  }
+  return written;
+}
+
+int WiFiClient::available() {
+  if (_socket < 0) {
+    return 0;
+  }
+
+  int count = 0;
+  if (ioctl(_socket, FIONREAD, &count) != 0) {
+    return 0;
+  }
+  return count;
+}
+
+int WiFiClient::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size) {
+  if (available() <= 0) {
+    return -1;
+  }
+
+  ssize_t result = recv(_socket, buffer, size, MSG_DONTWAIT);
+  return result > 0 ? (int)result : -1;
+}
+
+int WiFiClient::peek() {
+  uint8_t b;
+  if (_socket < 0 || recv(_socket, &b, 1, MSG_DONTWAIT | MSG_PEEK) != 1) {
+    return -1;
+  }
+  return b;
+}
+
+void WiFiClient::stop() {
+  if (_socket >= 0) {
+    close(_socket);
+    _socket = -1;
+  }
+}
+
+uint8_t WiFiClient::connected() {
+  if (_socket < 0) {
+    return 0;
+  }
+
+  /* a readable socket with nothing to read was closed by the peer */
+  struct pollfd descriptor = { _socket, POLLIN, 0 };
+  if (poll(&descriptor, 1, 0) > 0 && available() == 0) {
+    uint8_t b;
+    if (recv(_socket, &b, 1, MSG_DONTWAIT | MSG_PEEK) == 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,142 @@
+/**
+ * Host shim of the Arduino core, just enough of the ESP8266 flavour to
+ * build and exercise TelemetryNode on Linux.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define RTC_NOINIT_ATTR
+
+typedef uint32_t uint32;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+class String {
+    private:
+        std::string _value;
+
+    public:
+        String() {}
+        String(const char* value): _value(value == nullptr ? "" : value) {}
+        String(const std::string &value): _value(value) {}
+        unsigned int length() const { return _value.length(); }
+        const char* c_str() const { return _value.c_str(); }
+        bool operator==(const char* other) const { return _value == other; }
+        bool operator==(const String &other) const { return _value == other._value; }
+};
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t b) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size);
+        size_t write(const char *text) { return write((const uint8_t*)text, strlen(text)); }
+
+        size_t print(const char *text) { return write(text); }
+        size_t print(const String &text) { return write(text.c_str()); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(int value) { return _printFormat("%d", value); }
+        size_t print(unsigned int value) { return _printFormat("%u", value); }
+        size_t print(long value) { return _printFormat("%ld", value); }
+        size_t print(unsigned long value) { return _printFormat("%lu", value); }
+        size_t print(double value) { return _printFormat("%.2f", value); }
+
+        size_t println() { return write("\r\n"); }
+        template <typename T>
+        size_t println(T value) { size_t n = print(value); return n + println(); }
+
+    private:
+        template <typename T>
+        size_t _printFormat(const char *format, T value) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), format, value);
+            return write(buffer);
+        }
+};
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+};
+
+class IPAddress {
+    public:
+        IPAddress(): _address(0) {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d): _address((a << 24) | (b << 16) | (c << 8) | d) {}
+        uint32_t value() const { return _address; }
+
+    private:
+        uint32_t _address;
+};
+
+class Client : public Stream {
+    public:
+        virtual int connect(IPAddress ip, uint16_t port) = 0;
+        virtual int connect(const char *host, uint16_t port) = 0;
+        virtual size_t write(uint8_t b) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int read(uint8_t *buffer, size_t size) = 0;
+        virtual int peek() = 0;
+        virtual void flush() = 0;
+        virtual void stop() = 0;
+        virtual uint8_t connected() = 0;
+        virtual operator bool() = 0;
+        using Print::write;
+};
+
+/* ESP8266 reset reasons */
+enum rst_reason {
+    REASON_DEFAULT_RST = 0,
+    REASON_WDT_RST = 1,
+    REASON_EXCEPTION_RST = 2,
+    REASON_SOFT_WDT_RST = 3,
+    REASON_SOFT_RESTART = 4,
+    REASON_DEEP_SLEEP_AWAKE = 5,
+    REASON_EXT_SYS_RST = 6,
+};
+
+struct rst_info {
+    uint32 reason;
+};
+
+class EspClass {
+    public:
+        void restart();
+        uint32_t getFreeHeap() { return 40000; }
+        String getResetReason();
+        rst_info* getResetInfoPtr();
+        bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+        bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+        void wdtFeed() {}
+};
+
+extern EspClass ESP;
+
+extern "C" void system_restart(void);
+
+/* interrupt masking, modelled as one lock held from xt_rsil() to xt_wsr_ps() */
+uint32_t xt_rsil(uint32_t level);
+void xt_wsr_ps(uint32_t state);
+
+/* host test controls */
+void hostAdvanceMillis(unsigned long ms);
+void hostSetResetReason(uint32 reason);
+int hostRestartCount();
+
+#endif
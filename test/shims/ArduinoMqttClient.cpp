@@ -0,0 +1,363 @@
+#include <ArduinoMqttClient.h>
+
+#define MQTT_CONNECT     0x10
+#define MQTT_CONNACK     0x20
+#define MQTT_PUBLISH     0x30
+#define MQTT_PUBACK      0x40
+#define MQTT_SUBSCRIBE   0x82
+
+static void appendString(std::vector<uint8_t> &body, const std::string &value) {
+  body.push_back((value.size() >> 8) & 0xFF);
+  body.push_back(value.size() & 0xFF);
+  body.insert(body.end(), value.begin(), value.end());
+}
+
+static void appendId(std::vector<uint8_t> &body, uint16_t id) {
+  body.push_back(id >> 8);
+  body.push_back(id & 0xFF);
+}
+
+MqttClient::MqttClient(Client *client): _client(client) {
+}
+
+void MqttClient::setUsernamePassword(const char *username, const char *password) {
+  _username = username;
+  _password = password;
+}
+
+int MqttClient::beginMessage(const char *topic, unsigned long size, bool retain, uint8_t qos, bool dup) {
+  return beginMessage(topic, retain, qos, dup);
+}
+
+int MqttClient::beginMessage(const char *topic, bool retain, uint8_t qos, bool dup) {
+  _txWill = false;
+  _tx = { topic, "", retain, qos, dup };
+  return 1;
+}
+
+/**
+ * Like the library, QoS 1 waits for the PUBACK for up to the connection
+ * timeout and returns 0 without dropping the connection when it never arrives
+ */
+int MqttClient::endMessage() {
+  _published.push_back(_tx);
+
+  if (!connected()) {
+    return 0;
+  }
+
+  std::vector<uint8_t> body;
+  appendString(body, _tx.topic);
+
+  if (_tx.qos > 0) {
+    _txPacketId++;
+    if (_txPacketId == 0) {
+      _txPacketId = 1;
+    }
+    appendId(body, _txPacketId);
+  }
+  body.insert(body.end(), _tx.payload.begin(), _tx.payload.end());
+
+  uint8_t header = MQTT_PUBLISH | (_tx.dup ? 0x08 : 0) | ((_tx.qos & 0x03) << 1) | (_tx.retain ? 0x01 : 0);
+  if (!_writePacket(header, body)) {
+    return 0;
+  }
+
+  if (_tx.qos == 0) {
+    return 1;
+  }
+
+  _txAcked = false;
+  for (unsigned long start = millis(); millis() - start < _connectionTimeout && _client->connected();) {
+    poll();
+
+    if (_txAcked) {
+      return 1;
+    }
+    yield();
+  }
+
+  return 0;
+}
+
+int MqttClient::beginWill(const char *topic, unsigned short size, bool retain, uint8_t qos) {
+  return beginWill(topic, retain, qos);
+}
+
+int MqttClient::beginWill(const char *topic, bool retain, uint8_t qos) {
+  _txWill = true;
+  _will = { topic, "", retain, qos, false };
+  return 1;
+}
+
+int MqttClient::endWill() {
+  _txWill = false;
+  _hasWill = true;
+  return 1;
+}
+
+int MqttClient::subscribe(const char *topic, uint8_t qos) {
+  std::vector<uint8_t> body;
+  appendId(body, ++_txPacketId);
+  appendString(body, topic);
+  body.push_back(qos);
+  return _writePacket(MQTT_SUBSCRIBE, body) ? 1 : 0;
+}
+
+bool MqttClient::_writePacket(uint8_t header, const std::vector<uint8_t> &body) {
+  std::vector<uint8_t> packet;
+  packet.push_back(header);
+
+  size_t length = body.size();
+  do {
+    uint8_t encoded = length % 128;
+    length /= 128;
+    packet.push_back(encoded | (length > 0 ? 0x80 : 0));
+  } while (length > 0);
+
+  packet.insert(packet.end(), body.begin(), body.end());
+  return _client->write(packet.data(), packet.size()) == packet.size();
+}
+
+void MqttClient::poll() {
+  uint8_t buffer[512];
+
+  while (_client->available() > 0) {
+    int result = _client->read(buffer, sizeof(buffer));
+    if (result <= 0) {
+      break;
+    }
+    _rxBuffer.insert(_rxBuffer.end(), buffer, buffer + result);
+  }
+
+  /* handle every complete packet */
+  while (_rxBuffer.size() >= 2) {
+    size_t length = 0;
+    size_t multiplier = 1;
+    size_t index = 1;
+    bool isComplete = false;
+
+    while (index < _rxBuffer.size() && index <= 4) {
+      uint8_t encoded = _rxBuffer[index++];
+      length += (encoded & 0x7F) * multiplier;
+      multiplier *= 128;
+
+      if ((encoded & 0x80) == 0) {
+        isComplete = true;
+        break;
+      }
+    }
+
+    if (!isComplete || _rxBuffer.size() < index + length) {
+      break;
+    }
+
+    std::vector<uint8_t> packet(_rxBuffer.begin(), _rxBuffer.begin() + index + length);
+    _rxBuffer.erase(_rxBuffer.begin(), _rxBuffer.begin() + index + length);
+    _handlePacket(packet[0], packet.data() + index, length);
+  }
+
+  if (_connected && !_client->connected()) {
+    _connected = false;
+  }
+}
+
+void MqttClient::_handlePacket(uint8_t header, const uint8_t *body, size_t size) {
+  switch (header & 0xF0) {
+    case MQTT_CONNACK:
+      if (size >= 2) {
+        _rxConnAck = true;
+        _rxConnAckCode = body[1];
+      }
+      break;
+
+    case MQTT_PUBLISH: {
+      uint8_t qos = (header >> 1) & 0x03;
+      if (size < 2) {
+        break;
+      }
+
+      size_t topicLength = (body[0] << 8) | body[1];
+      size_t index = 2 + topicLength;
+      if (index + (qos > 0 ? 2 : 0) > size) {
+        break;
+      }
+
+      _rxTopic.assign((const char*)body + 2, topicLength);
+      if (qos > 0) {
+        std::vector<uint8_t> ack;
+        ack.push_back(body[index]);
+        ack.push_back(body[index + 1]);
+        _writePacket(MQTT_PUBACK, ack);
+        index += 2;
+      }
+
+      _rxPayload.assign(body + index, body + size);
+      _rxIndex = 0;
+      _rxLength = _rxPayload.size();
+      _rxMaxChunk = 0;
+
+      if (_onMessage != nullptr) {
+        _onMessage((int)_rxPayload.size());
+      }
+      break;
+    }
+
+    case MQTT_PUBACK:
+      if (size >= 2 && ((body[0] << 8) | body[1]) == _txPacketId) {
+        _txAcked = true;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+int MqttClient::connect(IPAddress ip, uint16_t port) {
+  char host[16];
+  uint32_t address = ip.value();
+  snprintf(host, sizeof(host), "%u.%u.%u.%u",
+    (unsigned)(address >> 24) & 0xFF, (unsigned)(address >> 16) & 0xFF,
+    (unsigned)(address >> 8) & 0xFF, (unsigned)address & 0xFF);
+  return connect(host, port);
+}
+
+int MqttClient::connect(const char *host, uint16_t port) {
+  _connected = false;
+  _rxBuffer.clear();
+  _rxConnAck = false;
+
+  if (!_client->connect(host, port)) {
+    _connectError = MQTT_CONNECTION_REFUSED;
+    return 0;
+  }
+
+  uint8_t flags = _cleanSession ? 0x02 : 0;
+  if (_hasWill) {
+    flags |= 0x04 | ((_will.qos & 0x03) << 3) | (_will.retain ? 0x20 : 0);
+  }
+  if (!_username.empty()) {
+    flags |= 0x80;
+  }
+  if (!_password.empty()) {
+    flags |= 0x40;
+  }
+
+  std::vector<uint8_t> body;
+  appendString(body, "MQTT");
+  body.push_back(0x04);  // protocol level 3.1.1
+  body.push_back(flags);
+  appendId(body, 60);    // keep alive seconds
+  appendString(body, _id);
+  if (_hasWill) {
+    appendString(body, _will.topic);
+    appendString(body, _will.payload);
+  }
+  if (!_username.empty()) {
+    appendString(body, _username);
+  }
+  if (!_password.empty()) {
+    appendString(body, _password);
+  }
+
+  if (!_writePacket(MQTT_CONNECT, body)) {
+    _connectError = MQTT_CONNECTION_REFUSED;
+    _client->stop();
+    return 0;
+  }
+
+  for (unsigned long start = millis(); millis() - start < _connectionTimeout && _client->connected();) {
+    poll();
+
+    if (_rxConnAck) {
+      break;
+    }
+    yield();
+  }
+
+  if (!_rxConnAck) {
+    _connectError = MQTT_CONNECTION_TIMEOUT;
+    _client->stop();
+    return 0;
+  }
+
+  if (_rxConnAckCode != 0) {
+    _connectError = _rxConnAckCode;
+    _client->stop();
+    return 0;
+  }
+
+  _connectError = MQTT_SUCCESS;
+  _connected = true;
+  return 1;
+}
+
+size_t MqttClient::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t MqttClient::write(const uint8_t *buffer, size_t size) {
+  std::string &payload = _txWill ? _will.payload : _tx.payload;
+  payload.append((const char*)buffer, size);
+  return size;
+}
+
+/* like the library, the message bytes still to come, not the bytes that arrived */
+int MqttClient::available() {
+  return _rxIndex < _rxLength ? (int)(_rxLength - _rxIndex) : 0;
+}
+
+int MqttClient::read() {
+  if (_rxIndex >= _rxPayload.size()) {
+    return -1;
+  }
+  return _rxPayload[_rxIndex++];
+}
+
+int MqttClient::read(uint8_t *buffer, size_t size) {
+  size_t remaining = _rxPayload.size() - _rxIndex;
+  if (remaining == 0) {
+    return -1;
+  }
+
+  size_t count = size < remaining ? size : remaining;
+  if (_rxMaxChunk > 0 && count > _rxMaxChunk) {
+    count = _rxMaxChunk;
+  }
+
+  memcpy(buffer, _rxPayload.data() + _rxIndex, count);
+  _rxIndex += count;
+  return (int)count;
+}
+
+int MqttClient::peek() {
+  if (_rxIndex >= _rxPayload.size()) {
+    return -1;
+  }
+  return _rxPayload[_rxIndex];
+}
+
+void MqttClient::flush() {
+  _client->flush();
+}
+
+void MqttClient::stop() {
+  _client->stop();
+  _connected = false;
+}
+
+uint8_t MqttClient::connected() {
+  if (_hostConnected >= 0) {
+    return _hostConnected;
+  }
+  return _connected && _client->connected();
+}
+
+void MqttClient::hostInjectMessage(const char *topic, const uint8_t *payload, size_t size, size_t maxChunk, size_t announcedSize) {
+  _rxTopic = topic;
+  _rxPayload.assign(payload, payload + size);
+  _rxIndex = 0;
+  _rxLength = announcedSize > size ? announcedSize : size;
+  _rxMaxChunk = maxChunk;
+}
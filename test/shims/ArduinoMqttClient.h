@@ -0,0 +1,109 @@
+/**
+ * Host shim of ArduinoMqttClient. Speaks enough MQTT 3.1.1 over the wrapped
+ * Client to talk to the host broker stand-in, follows the library's
+ * blocking QoS 1 behaviour and records every publish for tests.
+ */
+#ifndef HOST_ARDUINO_MQTT_CLIENT_H
+#define HOST_ARDUINO_MQTT_CLIENT_H
+
+#include <Arduino.h>
+#include <vector>
+
+#define MQTT_CONNECTION_REFUSED            -2
+#define MQTT_CONNECTION_TIMEOUT            -1
+#define MQTT_SUCCESS                        0
+
+/* a message handed to endMessage(), see MqttClient::hostPublished() */
+struct HostMqttPublish {
+    std::string topic;
+    std::string payload;
+    bool        retain;
+    uint8_t     qos;
+    bool        dup;
+};
+
+class MqttClient : public Client {
+    public:
+        MqttClient(Client *client);
+        MqttClient(Client &client): MqttClient(&client) {}
+
+        void onMessage(void(*callback)(int)) { _onMessage = callback; }
+        String messageTopic() const { return String(_rxTopic); }
+
+        int beginMessage(const char *topic, unsigned long size, bool retain = false, uint8_t qos = 0, bool dup = false);
+        int beginMessage(const char *topic, bool retain = false, uint8_t qos = 0, bool dup = false);
+        int endMessage();
+
+        int beginWill(const char *topic, unsigned short size, bool retain, uint8_t qos);
+        int beginWill(const char *topic, bool retain, uint8_t qos);
+        int endWill();
+
+        int subscribe(const char *topic, uint8_t qos = 0);
+        void poll();
+
+        int connect(IPAddress ip, uint16_t port = 1883) override;
+        int connect(const char *host, uint16_t port = 1883) override;
+        size_t write(uint8_t b) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        int available() override;
+        int read() override;
+        int read(uint8_t *buffer, size_t size) override;
+        int peek() override;
+        void flush() override;
+        void stop() override;
+        uint8_t connected() override;
+        operator bool() override { return true; }
+
+        void setId(const char *id) { _id = id; }
+        void setId(const String &id) { _id = id.c_str(); }
+        void setUsernamePassword(const char *username, const char *password);
+        void setCleanSession(bool cleanSession) { _cleanSession = cleanSession; }
+        void setConnectionTimeout(unsigned long timeout) { _connectionTimeout = timeout; }
+        int connectError() const { return _connectError; }
+
+        /* host test hooks */
+        /* announcedSize > size models a peer that stalls or drops after size bytes, 0 means size */
+        void hostInjectMessage(const char *topic, const uint8_t *payload, size_t size, size_t maxChunk = 0, size_t announcedSize = 0);
+        /* force connected() to 0 or 1, -1 goes back to the real connection state */
+        void hostSetConnected(int connected) { _hostConnected = connected; }
+        const std::vector<HostMqttPublish>& hostPublished() const { return _published; }
+        void hostClearPublished() { _published.clear(); }
+
+    private:
+        Client *_client;
+        void (*_onMessage)(int) = nullptr;
+
+        std::string _id;
+        std::string _username;
+        std::string _password;
+        bool _cleanSession = true;
+        bool _connected = false;
+        int _connectError = MQTT_SUCCESS;
+        unsigned long _connectionTimeout = 30 * 1000L;
+
+        /* outgoing message */
+        bool _txWill = false;
+        HostMqttPublish _tx;
+        HostMqttPublish _will;
+        bool _hasWill = false;
+        uint16_t _txPacketId = 0;
+        bool _txAcked = false;
+
+        /* incoming packets and the current incoming message */
+        std::vector<uint8_t> _rxBuffer;
+        bool _rxConnAck = false;
+        uint8_t _rxConnAckCode = 0;
+        std::string _rxTopic;
+        std::vector<uint8_t> _rxPayload;
+        size_t _rxIndex = 0;
+        size_t _rxLength = 0;
+        size_t _rxMaxChunk = 0;
+        int _hostConnected = -1;
+
+        std::vector<HostMqttPublish> _published;
+
+        bool _writePacket(uint8_t header, const std::vector<uint8_t> &body);
+        void _handlePacket(uint8_t header, const uint8_t *body, size_t size);
+};
+
+#endif
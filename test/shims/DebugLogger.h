@@ -0,0 +1,26 @@
+/**
+ * Host shim of DebugLogger, prints to stdout while logging is enabled.
+ */
+#ifndef HOST_DEBUG_LOGGER_H
+#define HOST_DEBUG_LOGGER_H
+
+#include <Arduino.h>
+
+class DebugLogger : public Print {
+    public:
+        DebugLogger(bool isLogging): _isLogging(isLogging) {}
+        void begin(unsigned long baudRate) {}
+        void setLogging(bool isLogging) { _isLogging = isLogging; }
+
+        size_t write(uint8_t b) override {
+            if (_isLogging) {
+                fputc(b, stdout);
+            }
+            return 1;
+        }
+
+    private:
+        bool _isLogging;
+};
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * Host shim of the ESP8266 WiFi library. WiFi is always connected and
+ * WiFiClient is a plain POSIX TCP socket.
+ */
+#ifndef HOST_ESP8266_WIFI_H
+#define HOST_ESP8266_WIFI_H
+
+#include <Arduino.h>
+
+#define WL_CONNECTED 3
+
+class WiFiClass {
+    public:
+        void begin(const char *ssid, const char *password) {}
+        int status() { return WL_CONNECTED; }
+        int8_t RSSI() { return -60; }
+};
+
+extern WiFiClass WiFi;
+
+class WiFiClient : public Client {
+    public:
+        WiFiClient(): _socket(-1) {}
+        virtual ~WiFiClient();
+
+        int connect(IPAddress ip, uint16_t port) override;
+        int connect(const char *host, uint16_t port) override;
+        size_t write(uint8_t b) override { return write(&b, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override;
+        int available() override;
+        int read() override;
+        int read(uint8_t *buffer, size_t size) override;
+        int peek() override;
+        void flush() override {}
+        void stop() override;
+        uint8_t connected() override;
+        operator bool() override { return _socket >= 0; }
+
+    protected:
+        int _socket;
+
+        int _connectSocket(const char *host, uint16_t port);
+};
+
+#include <WiFiClientSecure.h>
+
+#endif
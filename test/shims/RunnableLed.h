@@ -0,0 +1,16 @@
+/**
+ * Host shim of RunnableLed, animations are no-ops.
+ */
+#ifndef HOST_RUNNABLE_LED_H
+#define HOST_RUNNABLE_LED_H
+
+class RunnableLed {
+    public:
+        RunnableLed(int pin, int onState) {}
+        void off() {}
+        void run() {}
+        void flashTimes(int times, int msDelay) {}
+        void flashIndefinitely(int msDelay) {}
+};
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * Host stand-in for the ESP8266 Ticker. Like os_timer callbacks on the
+ * ESP8266, due tickers only run when the loop yields (yield() or delay()).
+ */
+#ifndef HOST_TICKER_H
+#define HOST_TICKER_H
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <vector>
+
+class Ticker {
+    private:
+        uint32_t _interval = 0;
+        unsigned long _tsLastRun = 0;
+        void (*_callback)(void*) = nullptr;
+        void *_arg = nullptr;
+
+        static std::vector<Ticker*>& _attached() {
+            static std::vector<Ticker*> attached;
+            return attached;
+        }
+
+    public:
+        Ticker() {}
+        Ticker(const Ticker&) {}
+        Ticker& operator=(const Ticker&) { return *this; }
+        ~Ticker() { detach(); }
+
+        template<typename TArg>
+        void attach_ms(uint32_t milliseconds, void (*callback)(TArg), TArg arg) {
+            detach();
+            _interval = milliseconds;
+            _tsLastRun = millis();
+            _callback = (void (*)(void*))callback;
+            _arg = (void*)arg;
+            _attached().push_back(this);
+        }
+
+        void detach() {
+            std::vector<Ticker*> &attached = _attached();
+            attached.erase(std::remove(attached.begin(), attached.end(), this), attached.end());
+        }
+
+        bool active() const {
+            std::vector<Ticker*> &attached = _attached();
+            return std::find(attached.begin(), attached.end(), this) != attached.end();
+        }
+
+        /* runs the callbacks of all due tickers, called from yield() and delay() */
+        static void hostRunDue() {
+            std::vector<Ticker*> due;
+            for (Ticker *ticker : _attached()) {
+                if (millis() - ticker->_tsLastRun >= ticker->_interval) {
+                    due.push_back(ticker);
+                }
+            }
+
+            for (Ticker *ticker : due) {
+                ticker->_tsLastRun = millis();
+                ticker->_callback(ticker->_arg);
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include <WiFiClientSecure.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+namespace BearSSL {
+
+WiFiClientSecure::~WiFiClientSecure() {
+  stop();
+
+  if (_context != nullptr) {
+    SSL_CTX_free(_context);
+  }
+}
+
+/* rebuilds an OpenSSL client session from the BearSSL session parameters */
+static SSL_SESSION* sessionFromParameters(SSL *ssl, const uint8_t *id, size_t idLength,
+                                          uint16_t version, uint16_t cipherSuite, const uint8_t *masterSecret) {
+  uint8_t cipherId[2] = { (uint8_t)(cipherSuite >> 8), (uint8_t)cipherSuite };
+  const SSL_CIPHER *cipher = SSL_CIPHER_find(ssl, cipherId);
+
+  if (idLength == 0 || cipher == nullptr) {
+    return nullptr;
+  }
+
+  SSL_SESSION *session = SSL_SESSION_new();
+  if (!SSL_SESSION_set1_id(session, id, idLength)
+      || !SSL_SESSION_set1_master_key(session, masterSecret, 48)
+      || !SSL_SESSION_set_cipher(session, cipher)
+      || !SSL_SESSION_set_protocol_version(session, version)) {
+    SSL_SESSION_free(session);
+    return nullptr;
+  }
+
+  SSL_SESSION_set_time(session, time(nullptr));
+  SSL_SESSION_set_timeout(session, 3600);
+  return session;
+}
+
+int WiFiClientSecure::connect(const char *host, uint16_t port) {
+  stop();
+
+  if (_context == nullptr) {
+    _context = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_max_proto_version(_context, TLS1_2_VERSION);
+    SSL_CTX_set_options(_context, SSL_OP_NO_TICKET | SSL_OP_NO_EXTENDED_MASTER_SECRET);
+    SSL_CTX_set_verify(_context, _isInsecure ? SSL_VERIFY_NONE : SSL_VERIFY_PEER, nullptr);
+  }
+
+  _socket = _connectSocket(host, port);
+  if (_socket < 0) {
+    return 0;
+  }
+
+  _ssl = SSL_new(_context);
+  SSL_set_fd(_ssl, _socket);
+
+  SSL_SESSION *resumeSession = nullptr;
+  if (_session != nullptr) {
+    resumeSession = sessionFromParameters(
+      _ssl,
+      _session->_session.session_id,
+      _session->_session.session_id_len,
+      _session->_session.version,
+      _session->_session.cipher_suite,
+      _session->_session.master_secret);
+
+    if (resumeSession != nullptr) {
+      SSL_set_session(_ssl, resumeSession);
+    }
+  }
+
+  int result = SSL_connect(_ssl);
+
+  if (resumeSession != nullptr) {
+    SSL_SESSION_free(resumeSession);
+  }
+
+  if (result != 1) {
+    ERR_clear_error();
+    stop();
+    return 0;
+  }
+
+  /* BearSSL keeps the parameters of a resumed session, only a full handshake replaces them */
+  if (_session != nullptr && !SSL_session_reused(_ssl)) {
+    SSL_SESSION *session = SSL_get_session(_ssl);
+    unsigned int idLength = 0;
+    const uint8_t *id = SSL_SESSION_get_id(session, &idLength);
+
+    memset(&_session->_session, 0, sizeof(_session->_session));
+    memcpy(_session->_session.session_id, id, idLength);
+    _session->_session.session_id_len = idLength;
+    _session->_session.version = SSL_SESSION_get_protocol_version(session);
+    _session->_session.cipher_suite = SSL_CIPHER_get_protocol_id(SSL_SESSION_get0_cipher(session));
+    SSL_SESSION_get_master_key(session, _session->_session.master_secret, 48);
+  }
+
+  /* reads after the handshake must not block the loop */
+  fcntl(_socket, F_SETFL, fcntl(_socket, F_GETFL) | O_NONBLOCK);
+  return 1;
+}
+
+size_t WiFiClientSecure::write(const uint8_t *buffer, size_t size) {
+  if (_ssl == nullptr) {
+    return 0;
+  }
+
+  size_t written = 0;
+  while (written < size) {
+    int result = SSL_write(_ssl, buffer + written, size - written);
+
+    if (result > 0) {
+      written += result;
+      continue;
+    }
+
+    int error = SSL_get_error(_ssl, result);
+    if (error != SSL_ERROR_WANT_WRITE && error != SSL_ERROR_WANT_READ) {
+      stop();
+      break;
+    }
+
+    struct pollfd descriptor = { _socket, (short)(error == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN), 0 };
+    poll(&descriptor, 1, 100);
+  }
+  return written;
+}
+
+/* moves every complete record waiting on the socket into the rx buffer */
+void WiFiClientSecure::_fillRxBuffer() {
+  if (_ssl == nullptr) {
+    return;
+  }
+
+  uint8_t chunk[1024];
+  for (;;) {
+    int result = SSL_read(_ssl, chunk, sizeof(chunk));
+
+    if (result > 0) {
+      _rxBuffer.insert(_rxBuffer.end(), chunk, chunk + result);
+      continue;
+    }
+
+    int error = SSL_get_error(_ssl, result);
+    if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) {
+      /* peer closed, keep what was already decrypted */
+      ERR_clear_error();
+      SSL_free(_ssl);
+      _ssl = nullptr;
+      WiFiClient::stop();
+    }
+    return;
+  }
+}
+
+int WiFiClientSecure::available() {
+  _fillRxBuffer();
+  return _rxBuffer.size();
+}
+
+int WiFiClientSecure::read() {
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int WiFiClientSecure::read(uint8_t *buffer, size_t size) {
+  if (available() <= 0) {
+    return -1;
+  }
+
+  size_t count = std::min(size, _rxBuffer.size());
+  memcpy(buffer, _rxBuffer.data(), count);
+  _rxBuffer.erase(_rxBuffer.begin(), _rxBuffer.begin() + count);
+  return count;
+}
+
+int WiFiClientSecure::peek() {
+  return available() > 0 ? _rxBuffer[0] : -1;
+}
+
+void WiFiClientSecure::stop() {
+  if (_ssl != nullptr) {
+    SSL_shutdown(_ssl);
+    SSL_free(_ssl);
+    _ssl = nullptr;
+  }
+
+  _rxBuffer.clear();
+  WiFiClient::stop();
+}
+
+uint8_t WiFiClientSecure::connected() {
+  _fillRxBuffer();
+  return !_rxBuffer.empty() || _ssl != nullptr;
+}
+
+}
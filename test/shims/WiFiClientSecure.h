@@ -0,0 +1,68 @@
+/**
+ * Host shim of the ESP8266 BearSSL secure client, backed by OpenSSL. Like
+ * BearSSL it speaks TLS 1.2 without session tickets and resumes from and
+ * updates the Session passed to setSession() on every connect.
+ */
+#ifndef HOST_WIFI_CLIENT_SECURE_H
+#define HOST_WIFI_CLIENT_SECURE_H
+
+#include <ESP8266WiFi.h>
+
+#include <vector>
+
+typedef struct ssl_st SSL;
+typedef struct ssl_ctx_st SSL_CTX;
+
+namespace BearSSL {
+
+/* mirrors br_ssl_session_parameters, the layout BearSSL::Session wraps */
+class Session {
+    friend class WiFiClientSecure;
+
+    public:
+        Session() { memset(&_session, 0, sizeof(_session)); }
+
+    private:
+        struct {
+            uint8_t  session_id[32];
+            uint8_t  session_id_len;
+            uint16_t version;
+            uint16_t cipher_suite;
+            uint8_t  master_secret[48];
+        } _session;
+};
+
+class WiFiClientSecure : public WiFiClient {
+    public:
+        WiFiClientSecure() {}
+        ~WiFiClientSecure() override;
+
+        void setInsecure() { _isInsecure = true; }
+        void setSession(Session *session) { _session = session; }
+
+        int connect(IPAddress ip, uint16_t port) override { return WiFiClient::connect(ip, port); }
+        int connect(const char *host, uint16_t port) override;
+        size_t write(uint8_t b) override { return write(&b, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override;
+        int available() override;
+        int read() override;
+        int read(uint8_t *buffer, size_t size) override;
+        int peek() override;
+        void stop() override;
+        uint8_t connected() override;
+
+    protected:
+        Session *_session = nullptr;
+        bool _isInsecure = false;
+        SSL_CTX *_context = nullptr;
+        SSL *_ssl = nullptr;
+        std::vector<uint8_t> _rxBuffer;
+
+        void _fillRxBuffer();
+};
+
+}
+
+using namespace BearSSL;
+
+#endif
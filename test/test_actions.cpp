@@ -0,0 +1,93 @@
+/**
+ * Drives processIncomingMessage through the shim MqttClient: valid actions,
+ * short reads, truncated and oversized payloads, and peers that stall or drop
+ * partway through a message.
+ */
+#include "host_node.h"
+
+#include <string>
+
+static WiFiClient wiFiClient;
+static MqttClient mqttClient(wiFiClient);
+static TelemetryNode telemNode(wiFiClient, mqttClient, hostNodeConfig());
+
+static JsonDocument deliver(const std::string &payload, int messageSize, size_t maxChunk) {
+  mqttClient.hostInjectMessage("host-node/actions", (const uint8_t*)payload.data(), payload.size(), maxChunk);
+  return telemNode.processIncomingMessage(messageSize);
+}
+
+/* delivers the first sent bytes of a messageSize byte message, then the peer stalls or drops */
+static JsonDocument deliverPartial(const std::string &payload, size_t sent, int messageSize, bool isConnected) {
+  mqttClient.hostSetConnected(isConnected ? 1 : 0);
+  mqttClient.hostInjectMessage("host-node/actions", (const uint8_t*)payload.data(), sent, 4, messageSize);
+
+  unsigned long start = millis();
+  JsonDocument json = telemNode.processIncomingMessage(messageSize);
+  HOST_CHECK(millis() - start < TELEMETRY_ACTION_READ_TIMEOUT + 1000);
+
+  mqttClient.hostSetConnected(-1);
+  return json;
+}
+
+/* the event run() publishes for a pending action flag, empty when there is none */
+static std::string publishedEvent() {
+  mqttClient.hostClearPublished();
+  telemNode.run();
+
+  for (const HostMqttPublish &publish : mqttClient.hostPublished()) {
+    if (publish.topic == "host-node/device/events") {
+      return publish.payload;
+    }
+  }
+  return "";
+}
+
+int main() {
+  telemNode.begin();
+
+  const std::string enable = "{ \"action\": 555 }";
+  const std::string disable = "{ \"action\": 666 }";
+
+  /* whole payload in one read */
+  JsonDocument json = deliver(enable, enable.size(), 0);
+  HOST_CHECK(json["action"].as<int>() == 555);
+  HOST_CHECK(publishedEvent() == "EVENT_DEVICE_HEARTBEAT_ENABLED");
+
+  /* payload arriving one byte per read is still parsed */
+  json = deliver(disable, disable.size(), 1);
+  HOST_CHECK(json["action"].as<int>() == 666);
+  HOST_CHECK(publishedEvent() == "EVENT_DEVICE_HEARTBEAT_DISABLED");
+
+  /* payload ending before the announced size is ignored */
+  json = deliver(enable.substr(0, 10), enable.size(), 3);
+  HOST_CHECK(json.isNull());
+  HOST_CHECK(publishedEvent() == "");
+
+  /* empty and negative sizes are ignored */
+  HOST_CHECK(deliver(enable, 0, 0).isNull());
+  HOST_CHECK(deliver(enable, -5, 0).isNull());
+  HOST_CHECK(publishedEvent() == "");
+
+  /* oversized payloads are drained and ignored */
+  std::string oversized = "{ \"action\": 555, \"pad\": \"" + std::string(TELEMETRY_MAX_ACTION_PAYLOAD_SIZE, 'x') + "\" }";
+  HOST_CHECK(deliver(oversized, oversized.size(), 0).isNull());
+  HOST_CHECK(mqttClient.available() == 0);
+  HOST_CHECK(publishedEvent() == "");
+
+  /* a peer stalling or dropping mid payload gives up instead of spinning */
+  HOST_CHECK(deliverPartial(enable, 10, enable.size(), true).isNull());
+  HOST_CHECK(deliverPartial(enable, 10, enable.size(), false).isNull());
+  HOST_CHECK(publishedEvent() == "");
+
+  /* as does the drain of an oversized payload */
+  HOST_CHECK(deliverPartial(oversized, 100, oversized.size(), true).isNull());
+  HOST_CHECK(deliverPartial(oversized, 100, oversized.size(), false).isNull());
+  HOST_CHECK(publishedEvent() == "");
+
+  /* malformed JSON is ignored */
+  HOST_CHECK(deliver("{ \"action\": ", 12, 0).isNull());
+  HOST_CHECK(publishedEvent() == "");
+
+  printf("test_actions: OK\n");
+  return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * Interrupt event queue: two producer threads standing in for ISRs run
+ * queueEvent() while the loop drains it through run(). Nothing below
+ * capacity is lost, each producer's events stay in order and every rejected
+ * event is counted.
+ */
+#include "host_node.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define QUEUE_CAPACITY TELEMETRY_EVENT_QUEUE_SIZE
+#define PRODUCER_COUNT 2
+
+static WiFiClient wiFiClient;
+static MqttClient mqttClient(wiFiClient);
+static TelemetryNode telemNode(wiFiClient, mqttClient, hostNodeConfig());
+
+static size_t delivered(const std::vector<int32_t> (&values)[PRODUCER_COUNT]) {
+  size_t count = 0;
+  for (const std::vector<int32_t> &producerValues : values) {
+    count += producerValues.size();
+  }
+  return count;
+}
+
+/* runs the loop once and appends the published event values per id, in order */
+static void drain(std::vector<int32_t> (&values)[PRODUCER_COUNT], unsigned long &overflows) {
+  mqttClient.hostClearPublished();
+  telemNode.run();
+
+  for (const HostMqttPublish &publish : mqttClient.hostPublished()) {
+    if (publish.topic != "host-node/device/events") {
+      continue;
+    }
+
+    JsonDocument json;
+    HOST_CHECK(deserializeJson(json, publish.payload.c_str()) == DeserializationError::Ok);
+
+    JsonArray events = json["events"];
+    HOST_CHECK(events.size() > 0 && events.size() <= TELEMETRY_EVENT_BATCH_SIZE);
+
+    for (size_t i = 0; i < events.size(); i++) {
+      int id = events[i]["id"].as<int>();
+      HOST_CHECK(id >= 0 && id < PRODUCER_COUNT);
+      values[id].push_back(events[i]["value"].as<int32_t>());
+    }
+    overflows = json["overflows"].as<unsigned long>();
+  }
+}
+
+int main() {
+  telemNode.begin();
+
+  std::vector<int32_t> values[PRODUCER_COUNT];
+  unsigned long overflows = 0;
+
+  /* fill to capacity with nothing draining, the next event overflows */
+  for (int32_t i = 0; i < QUEUE_CAPACITY; i++) {
+    HOST_CHECK(telemNode.queueEvent(0, i));
+  }
+  HOST_CHECK(!telemNode.queueEvent(0, QUEUE_CAPACITY));
+  HOST_CHECK(telemNode.getStats().event_queue_overflows == 1);
+
+  while (values[0].size() < QUEUE_CAPACITY) {
+    size_t drained = values[0].size();
+    drain(values, overflows);
+    HOST_CHECK(values[0].size() > drained);
+  }
+
+  for (int32_t i = 0; i < QUEUE_CAPACITY; i++) {
+    HOST_CHECK(values[0][i] == i);
+  }
+  HOST_CHECK(overflows == 1);
+
+  /* producers racing each other and the consumer */
+  const int32_t eventCount = 20000;
+  std::vector<bool> accepted[PRODUCER_COUNT];
+  unsigned long rejected[PRODUCER_COUNT] = {};
+  std::atomic<int> producing(PRODUCER_COUNT);
+  std::vector<std::thread> producers;
+
+  for (int id = 0; id < PRODUCER_COUNT; id++) {
+    accepted[id].assign(eventCount, false);
+
+    producers.emplace_back([&, id]() {
+      for (int32_t i = 0; i < eventCount; i++) {
+        if (telemNode.queueEvent(id, i)) {
+          accepted[id][i] = true;
+        } else {
+          rejected[id]++;
+        }
+
+        /* bursts of interrupts, sometimes faster than the loop drains them */
+        if (i % 16 == 0) {
+          std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+      }
+      producing--;
+    });
+  }
+
+  for (std::vector<int32_t> &producerValues : values) {
+    producerValues.clear();
+  }
+  while (producing > 0) {
+    drain(values, overflows);
+  }
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+
+  size_t drained;
+  do {
+    drained = delivered(values);
+    drain(values, overflows);
+  } while (delivered(values) != drained);
+
+  /* every accepted event arrived once, in its producer's order, and nothing else did */
+  unsigned long totalRejected = 0;
+  for (int id = 0; id < PRODUCER_COUNT; id++) {
+    size_t next = 0;
+    for (int32_t i = 0; i < eventCount; i++) {
+      if (accepted[id][i]) {
+        HOST_CHECK(next < values[id].size());
+        HOST_CHECK(values[id][next] == i);
+        next++;
+      }
+    }
+    HOST_CHECK(next == values[id].size());
+    totalRejected += rejected[id];
+  }
+
+  /* every rejected event was counted */
+  HOST_CHECK(telemNode.getStats().event_queue_overflows == 1 + totalRejected);
+  HOST_CHECK(telemNode.getStats().events_published == QUEUE_CAPACITY + delivered(values));
+
+  printf("test_event_queue: OK (%zu delivered, %lu overflowed)\n", delivered(values), totalRejected);
+  return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * QoS 1 publishes against the broker stand-in: acknowledged publishes report
+ * their latency, a missed PUBACK drops the connection and the message is
+ * resent after the reconnect as a new publish without the DUP flag. A missed
+ * PUBACK during the reconnect itself is retried instead of restarting.
+ */
+#include "host_node.h"
+#include "host_broker.h"
+
+#include <signal.h>
+
+#define ACK_TIMEOUT 200
+#define KEEP_ALIVE  1000
+
+static std::vector<HostBrokerPublish> brokerPublishes(HostBroker &broker, const char *topic) {
+  std::vector<HostBrokerPublish> publishes;
+  for (const HostBrokerPublish &publish : broker.publishes()) {
+    if (publish.topic == topic) {
+      publishes.push_back(publish);
+    }
+  }
+  return publishes;
+}
+
+int main() {
+  signal(SIGPIPE, SIG_IGN);
+
+  HostBroker broker(false);
+
+  TelemetryNodeConfig config = hostNodeConfig("127.0.0.1", broker.port());
+  config.device.qos_reset_reason = 1;
+  config.device.time_alive.qos = 1;
+  config.timeout.keep_alive = KEEP_ALIVE;
+
+  WiFiClient wiFiClient;
+  MqttClient mqttClient(wiFiClient);
+  mqttClient.setConnectionTimeout(ACK_TIMEOUT);
+  TelemetryNode telemNode(wiFiClient, mqttClient, config);
+
+  telemNode.begin();
+  telemNode.connect();
+
+  /* acknowledged on the first send */
+  HOST_CHECK(brokerPublishes(broker, "host-node/device/reset").size() == 1);
+  HOST_CHECK(brokerPublishes(broker, "host-node/device/reset")[0].qos == 1);
+  HOST_CHECK(telemNode.getStats().qos_acked == 1);
+  HOST_CHECK(telemNode.getStats().qos_pending == 0);
+  HOST_CHECK(telemNode.getStats().max_ack_latency < ACK_TIMEOUT);
+
+  /* missed PUBACK: the connection is dropped and the message kept */
+  broker.setAckPublishes(false);
+  telemNode.publishTimeAlive();
+  HOST_CHECK(telemNode.getStats().qos_ack_timeouts == 1);
+  HOST_CHECK(telemNode.getStats().qos_pending == 1);
+  HOST_CHECK(!mqttClient.connected());
+
+  /* later publishes queue behind it without waiting */
+  unsigned long tsPublish = millis();
+  telemNode.publishTimeAlive();
+  HOST_CHECK(millis() - tsPublish < ACK_TIMEOUT);
+  HOST_CHECK(telemNode.getStats().qos_pending == 2);
+  HOST_CHECK(telemNode.getStats().qos_ack_timeouts == 1);
+
+  /* next run reconnects, the reset reason published on connect waits its turn */
+  broker.setAckPublishes(true);
+  telemNode.run();
+  HOST_CHECK(mqttClient.connected());
+  HOST_CHECK(telemNode.getStats().mqtt_connects == 2);
+  HOST_CHECK(telemNode.getStats().qos_pending == 3);
+
+  /* one resend per run, oldest first */
+  for (int i = 0; i < 3; i++) {
+    telemNode.run();
+    HOST_CHECK(telemNode.getStats().qos_pending == 2 - i);
+  }
+  HOST_CHECK(telemNode.getStats().qos_resends == 3);
+  HOST_CHECK(telemNode.getStats().qos_acked == 4);
+
+  /* a resend is a new publish: new packet id, no DUP flag */
+  std::vector<HostBrokerPublish> timeAlive = brokerPublishes(broker, "host-node/device/alive-time");
+  HOST_CHECK(timeAlive.size() == 3);
+  for (size_t i = 1; i < timeAlive.size(); i++) {
+    HOST_CHECK(!timeAlive[i].dup);
+    HOST_CHECK(timeAlive[i].packetId != timeAlive[0].packetId);
+  }
+
+  std::vector<HostBrokerPublish> publishes = broker.publishes();
+  HOST_CHECK(publishes.back().topic == "host-node/device/reset");
+
+  /* publishing while disconnected fills the buffer, the oldest is dropped */
+  broker.dropClient();
+  for (int i = 0; i < 200 && mqttClient.connected(); i++) {
+    delay(10);
+  }
+  HOST_CHECK(!mqttClient.connected());
+
+  for (int i = 0; i < TELEMETRY_QOS_RESEND_BUFFER_SIZE + 1; i++) {
+    telemNode.publishTimeAlive();
+  }
+  HOST_CHECK(telemNode.getStats().qos_pending == TELEMETRY_QOS_RESEND_BUFFER_SIZE);
+  HOST_CHECK(telemNode.getStats().qos_dropped == 1);
+  HOST_CHECK(telemNode.getStats().qos_ack_timeouts == 1);
+
+  /* reconnect on the next keep alive, the reset reason pushes out another old message */
+  hostAdvanceMillis(KEEP_ALIVE);
+  for (int i = 0; i < 2 * TELEMETRY_QOS_RESEND_BUFFER_SIZE && telemNode.getStats().qos_pending > 0; i++) {
+    telemNode.run();
+  }
+  HOST_CHECK(telemNode.getStats().qos_pending == 0);
+  HOST_CHECK(telemNode.getStats().qos_dropped == 2);
+  HOST_CHECK(brokerPublishes(broker, "host-node/device/alive-time").size() == 3 + TELEMETRY_QOS_RESEND_BUFFER_SIZE - 1);
+  HOST_CHECK(broker.publishes().back().topic == "host-node/device/reset");
+
+  /* a PUBACK missed while reconnecting keeps the message and retries, no restart */
+  broker.dropClient();
+  for (int i = 0; i < 200 && mqttClient.connected(); i++) {
+    delay(10);
+  }
+  broker.setAckPublishes(false);
+  unsigned long connects = telemNode.getStats().mqtt_connects;
+  unsigned long ackTimeouts = telemNode.getStats().qos_ack_timeouts;
+
+  hostAdvanceMillis(KEEP_ALIVE);
+  telemNode.run();
+  HOST_CHECK(hostRestartCount() == 0);
+  HOST_CHECK(telemNode.getStats().mqtt_connects == connects + 1);
+  HOST_CHECK(telemNode.getStats().qos_ack_timeouts == ackTimeouts + 1);
+  HOST_CHECK(telemNode.getStats().qos_pending == 1);
+  HOST_CHECK(!mqttClient.connected());
+
+  /* the next run reconnects right away and delivers the kept and the new reset reason */
+  broker.setAckPublishes(true);
+  size_t resetCount = brokerPublishes(broker, "host-node/device/reset").size();
+  for (int i = 0; i < 2 * TELEMETRY_QOS_RESEND_BUFFER_SIZE && telemNode.getStats().qos_pending > 0; i++) {
+    telemNode.run();
+  }
+  HOST_CHECK(hostRestartCount() == 0);
+  HOST_CHECK(telemNode.getStats().mqtt_connects == connects + 2);
+  HOST_CHECK(telemNode.getStats().qos_pending == 0);
+  HOST_CHECK(brokerPublishes(broker, "host-node/device/reset").size() == resetCount + 2);
+
+  printf("test_qos: OK\n");
+  return 0;
+}
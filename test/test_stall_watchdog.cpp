@@ -0,0 +1,106 @@
+/**
+ * Stall watchdog: the ticker restarts the device for a phase that overran
+ * the deadline, the next boot reports that stall once and runtime overruns
+ * only show up in the stats. With the watchdog disabled the stall record's
+ * RTC memory is left alone.
+ */
+#include "host_node.h"
+
+#define STALL_DEADLINE 5000
+
+static TelemetryNodeConfig stallConfig(long deadline) {
+  TelemetryNodeConfig config = hostNodeConfig();
+  config.timeout.loop_stall_deadline = deadline;
+  return config;
+}
+
+/* a fresh node per boot, its destructor stops the ticker like a reset would */
+struct Boot {
+  WiFiClient wiFiClient;
+  MqttClient mqttClient;
+  TelemetryNode telemNode;
+
+  explicit Boot(uint32 resetReason, long deadline = STALL_DEADLINE)
+    : mqttClient(wiFiClient), telemNode(wiFiClient, mqttClient, stallConfig(deadline)) {
+    hostSetResetReason(resetReason);
+    telemNode.begin();
+  }
+};
+
+int main() {
+  /* power on, nothing to report */
+  {
+    Boot boot(REASON_DEFAULT_RST);
+    HOST_CHECK(boot.telemNode.getStats().reset_stall_phase == PHASE_NONE);
+
+    /* user code within the deadline */
+    boot.telemNode.run();
+    hostAdvanceMillis(STALL_DEADLINE - 1000);
+    yield();
+    HOST_CHECK(hostRestartCount() == 0);
+
+    /* user code overran the deadline but returned before the check, stats only */
+    hostAdvanceMillis(2000);
+    boot.telemNode.run();
+    HOST_CHECK(hostRestartCount() == 0);
+    HOST_CHECK(boot.telemNode.getStats().last_stall_phase == PHASE_USER_TASK);
+    HOST_CHECK(boot.telemNode.getStats().last_stall_duration >= STALL_DEADLINE);
+    HOST_CHECK(boot.telemNode.getStats().reset_stall_phase == PHASE_NONE);
+
+    /* user code stuck past the deadline, the ticker restarts the device */
+    hostAdvanceMillis(STALL_DEADLINE + 1000);
+    yield();
+    HOST_CHECK(hostRestartCount() == 1);
+  }
+
+  /* the boot after the stall restart reports it */
+  {
+    Boot boot(REASON_SOFT_RESTART);
+    HOST_CHECK(boot.telemNode.getStats().reset_stall_phase == PHASE_USER_TASK);
+    HOST_CHECK(boot.telemNode.getStats().reset_stall_duration >= STALL_DEADLINE);
+    HOST_CHECK(boot.telemNode.getStats().last_stall_phase == PHASE_NONE);
+
+    /* leave a phase running for the hardware watchdog below */
+    boot.telemNode.run();
+  }
+
+  /* hardware watchdog reset without a recorded stall blames the running phase */
+  {
+    Boot boot(REASON_SOFT_WDT_RST);
+    HOST_CHECK(boot.telemNode.getStats().reset_stall_phase == PHASE_USER_TASK);
+    HOST_CHECK(boot.telemNode.getStats().reset_stall_duration == 0);
+  }
+
+  /* a stall is only reported for the reset it caused */
+  {
+    Boot boot(REASON_SOFT_RESTART);
+    HOST_CHECK(boot.telemNode.getStats().reset_stall_phase == PHASE_NONE);
+  }
+
+  HOST_CHECK(hostRestartCount() == 1);
+
+  /* watchdog disabled, RTC memory belongs to the sketch */
+  {
+    uint32_t sentinel[sizeof(TelemetryStallRecord) / 4];
+    memset(sentinel, 0xA5, sizeof(sentinel));
+    ESP.rtcUserMemoryWrite(TELEMETRY_RTC_STALL_OFFSET, sentinel, sizeof(sentinel));
+
+    Boot boot(REASON_SOFT_WDT_RST, 0);
+    HOST_CHECK(boot.telemNode.getStats().reset_stall_phase == PHASE_NONE);
+
+    boot.telemNode.run();
+    hostAdvanceMillis(STALL_DEADLINE + 1000);
+    yield();
+    boot.telemNode.run();
+    HOST_CHECK(boot.telemNode.getStats().last_stall_phase == PHASE_NONE);
+
+    uint32_t memory[sizeof(sentinel) / 4];
+    ESP.rtcUserMemoryRead(TELEMETRY_RTC_STALL_OFFSET, memory, sizeof(memory));
+    HOST_CHECK(memcmp(memory, sentinel, sizeof(sentinel)) == 0);
+  }
+
+  HOST_CHECK(hostRestartCount() == 1);
+
+  printf("test_stall_watchdog: OK\n");
+  return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * TLS connects against the loopback broker stand-in: reconnects resume the
+ * cached session, handshake time and resumptions are reported and the RTC
+ * copy of the session is only kept when persistence is enabled.
+ */
+#include "host_node.h"
+#include "host_broker.h"
+
+#include <signal.h>
+
+#define CONNACK_DELAY 100
+#define KEEP_ALIVE    1000
+
+static HostBroker *broker;
+
+/* a fresh client stack per boot, like the device after a reset */
+struct Boot {
+  WiFiClientSecure secureClient;
+  MqttClient mqttClient;
+  TelemetryNode telemNode;
+
+  Boot(bool isPersistingSession)
+      : mqttClient(secureClient), telemNode(secureClient, mqttClient, bootConfig(isPersistingSession)) {
+    secureClient.setInsecure();
+    hostSetResetReason(REASON_SOFT_RESTART);
+    telemNode.begin();
+    telemNode.connect();
+    HOST_CHECK(mqttClient.connected());
+  }
+
+  static TelemetryNodeConfig bootConfig(bool isPersistingSession) {
+    TelemetryNodeConfig config = hostNodeConfig("127.0.0.1", broker->port());
+    config.connection.tls_session_persist_rtc = isPersistingSession;
+    config.timeout.keep_alive = KEEP_ALIVE;
+    return config;
+  }
+
+  /* broker drops the connection, the next keep alive reconnects */
+  void reconnect() {
+    broker->dropClient();
+    for (int i = 0; i < 200 && mqttClient.connected(); i++) {
+      delay(10);
+    }
+    HOST_CHECK(!mqttClient.connected());
+
+    hostAdvanceMillis(KEEP_ALIVE);
+    telemNode.run();
+    HOST_CHECK(mqttClient.connected());
+  }
+};
+
+static bool isRtcSessionEmpty() {
+  uint32_t magic = 1;
+  ESP.rtcUserMemoryRead(TELEMETRY_RTC_TLS_SESSION_OFFSET, &magic, sizeof(magic));
+  return magic == 0;
+}
+
+int main() {
+  signal(SIGPIPE, SIG_IGN);
+
+  HostBroker tlsBroker(true);
+  tlsBroker.setConnAckDelay(CONNACK_DELAY);
+  broker = &tlsBroker;
+
+  {
+    Boot boot(true);
+
+    /* first connect is a full handshake, the timing covers TCP, TLS and CONNECT */
+    TelemetryNodeStats stats = boot.telemNode.getStats();
+    HOST_CHECK(stats.mqtt_connects == 1);
+    HOST_CHECK(stats.tls_sessions_resumed == 0);
+    HOST_CHECK(stats.last_handshake_duration >= CONNACK_DELAY);
+    HOST_CHECK(tlsBroker.resumedSessions() == 0);
+
+    /* reconnect resumes the cached session */
+    boot.reconnect();
+    stats = boot.telemNode.getStats();
+    HOST_CHECK(stats.mqtt_connects == 2);
+    HOST_CHECK(stats.tls_sessions_resumed == 1);
+    HOST_CHECK(stats.last_handshake_duration >= CONNACK_DELAY);
+    HOST_CHECK(tlsBroker.resumedSessions() == 1);
+
+    boot.reconnect();
+    HOST_CHECK(boot.telemNode.getStats().tls_sessions_resumed == 2);
+    HOST_CHECK(tlsBroker.resumedSessions() == 2);
+    HOST_CHECK(!isRtcSessionEmpty());
+    tlsBroker.dropClient();
+  }
+
+  /* with persistence on, the first connect after a reset resumes from RTC memory */
+  {
+    Boot boot(true);
+    HOST_CHECK(boot.telemNode.getStats().tls_sessions_resumed == 1);
+    HOST_CHECK(tlsBroker.resumedSessions() == 3);
+    tlsBroker.dropClient();
+  }
+
+  /* with persistence off, the RTC copy is wiped and never written again */
+  {
+    Boot boot(false);
+    HOST_CHECK(boot.telemNode.getStats().tls_sessions_resumed == 0);
+    HOST_CHECK(tlsBroker.resumedSessions() == 3);
+    HOST_CHECK(isRtcSessionEmpty());
+
+    /* the in-memory cache still resumes reconnects */
+    boot.reconnect();
+    HOST_CHECK(boot.telemNode.getStats().tls_sessions_resumed == 1);
+    HOST_CHECK(tlsBroker.resumedSessions() == 4);
+    HOST_CHECK(isRtcSessionEmpty());
+    tlsBroker.dropClient();
+  }
+
+  /* with persistence off and no session left behind, RTC memory belongs to the sketch */
+  {
+    uint32_t sentinel[sizeof(TelemetryTlsSessionRecord) / 4];
+    memset(sentinel, 0xA5, sizeof(sentinel));
+    ESP.rtcUserMemoryWrite(TELEMETRY_RTC_TLS_SESSION_OFFSET, sentinel, sizeof(sentinel));
+
+    Boot boot(false);
+    boot.reconnect();
+
+    uint32_t memory[sizeof(sentinel) / 4];
+    ESP.rtcUserMemoryRead(TELEMETRY_RTC_TLS_SESSION_OFFSET, memory, sizeof(memory));
+    HOST_CHECK(memcmp(memory, sentinel, sizeof(sentinel)) == 0);
+    tlsBroker.dropClient();
+  }
+
+  printf("test_tls_resume: OK\n");
+  return 0;
+}